@@ -1,70 +1,512 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "my_memory.h"
 
 namespace crt
 {
+	// the predicate of every sort here returns true if lhs should be placed after rhs,
+	// so "lhs goes before rhs" is p(rhs, lhs)
+
 	template <typename IteratorType, typename Predicate>
 	auto insertion_sort(IteratorType begin, IteratorType end, Predicate p)
 	{
-		const int n = static_cast<int>(end - begin);
+		if (begin == end)
+			return;
 
-		for (int i = 1; i < n; i++)
+		for (auto it = begin + 1; it != end; ++it)
 		{
-			int j = i - 1;
+			auto hole = it;
+			auto previous = it - 1;
+			if (!p(*previous, *hole))
+				continue;
 
-			while (j >= 0 && p(*(begin + j), *(begin + j + 1)))
+			// shift the larger elements right instead of swapping the new one down
+			auto value = crt::move(*hole);
+			do
 			{
-				crt::swap(*(begin + j + 1), *(begin + j));
-				j = j - 1;
-			}
+				*hole = crt::move(*previous);
+				--hole;
+			} while (hole != begin && p(*--previous, value));
+
+			*hole = crt::move(value);
 		}
 	}
 
-	template <typename IteratorType, typename Predicate>
-	auto quicksort_partition(IteratorType begin, IteratorType end, Predicate p)
+	namespace detail
 	{
-		auto pivot = end - 1; // pivot is the last element
+		// below this many elements insertion sort wins over partitioning
+		constexpr size_t sort_insertion_threshold = 24;
+
+		// above this many elements the pivot is the median of three medians
+		constexpr size_t sort_ninther_threshold = 128;
+
+		// partial_insertion_sort gives up after moving this many elements
+		constexpr size_t sort_partial_insertion_limit = 8;
+
+		// elements classified before any is moved by the block partition, offsets must fit in a byte
+		constexpr size_t sort_block_size = 64;
 
-		auto i = begin - 1; // this points to the last element of the left partition
-		for (auto j = begin; j != end - 1; ++j)
+		template <typename IteratorType>
+		using sort_value_t = std::remove_reference_t<decltype(*std::declval<IteratorType>())>;
+
+		// comparisons are cheap and the elements small enough to move freely, worth partitioning without branches
+		template <typename T>
+		constexpr bool is_block_partitioned_v = std::is_arithmetic_v<T> || std::is_pointer_v<T>;
+
+		template <typename IteratorType>
+		struct partition_result
+		{
+			IteratorType pivot;
+			bool already_partitioned;
+		};
+
+		// insertion sort for a range that is not the leftmost one: the element before begin goes before
+		// every element of the range and stops the shifting, no bound check needed
+		template <typename IteratorType, typename Predicate>
+		void unguarded_insertion_sort(IteratorType begin, IteratorType end, Predicate p)
 		{
-			// is j less than pivot?
-			if (!p(*j, *pivot))
+			if (begin == end)
+				return;
+
+			for (auto it = begin + 1; it != end; ++it)
 			{
-				++i;
-				crt::swap(*j, *i);
+				auto hole = it;
+				auto previous = it - 1;
+				if (!p(*previous, *hole))
+					continue;
+
+				auto value = crt::move(*hole);
+				do
+				{
+					*hole = crt::move(*previous);
+					--hole;
+				} while (p(*--previous, value));
+
+				*hole = crt::move(value);
 			}
 		}
 
-		// put the pivot in its place
-		crt::swap(*(i + 1), *pivot);
+		// insertion sort that gives up when the range turns out to be far from sorted, returns true if it sorted it
+		template <typename IteratorType, typename Predicate>
+		bool partial_insertion_sort(IteratorType begin, IteratorType end, Predicate p)
+		{
+			if (begin == end)
+				return true;
 
-		// return a iterator to the pivot
-		return i + 1;
-	}
+			size_t moved = 0;
+			for (auto it = begin + 1; it != end; ++it)
+			{
+				auto hole = it;
+				auto previous = it - 1;
+				if (!p(*previous, *hole))
+					continue;
 
-	template <typename IteratorType, typename Predicate>
-	void quicksort(IteratorType begin, IteratorType end, Predicate p)
-	{
-		const int n = static_cast<int>(end - begin);
-		if (n < 10)
+				auto value = crt::move(*hole);
+				do
+				{
+					*hole = crt::move(*previous);
+					--hole;
+				} while (hole != begin && p(*--previous, value));
+
+				*hole = crt::move(value);
+
+				moved += static_cast<size_t>(it - hole);
+				if (moved > sort_partial_insertion_limit)
+					return false;
+			}
+
+			return true;
+		}
+
+		template <typename IteratorType, typename Predicate>
+		void sort2(IteratorType a, IteratorType b, Predicate p)
 		{
-			// fall back to insertion sort for small range of data
-			return insertion_sort(begin, end, p);
+			if (p(*a, *b))
+				crt::swap(*a, *b);
 		}
 
-		if (begin != end)
+		// leaves the median of the three in b
+		template <typename IteratorType, typename Predicate>
+		void sort3(IteratorType a, IteratorType b, IteratorType c, Predicate p)
 		{
-			auto pivot = quicksort_partition(begin, end, p);
+			sort2(a, b, p);
+			sort2(b, c, p);
+			sort2(a, b, p);
+		}
+
+		template <typename IteratorType, typename Predicate, typename T>
+		void sift_down(IteratorType begin, size_t size, size_t hole, T value, Predicate p)
+		{
+			for (;;)
+			{
+				auto child = 2 * hole + 1;
+				if (child >= size)
+					break;
 
-			quicksort(begin, pivot, p);
-			quicksort(pivot + 1, end, p);
+				// the child that goes last moves up
+				if (child + 1 < size && p(*(begin + (child + 1)), *(begin + child)))
+					++child;
+
+				if (!p(*(begin + child), value))
+					break;
+
+				*(begin + hole) = crt::move(*(begin + child));
+				hole = child;
+			}
+
+			*(begin + hole) = crt::move(value);
+		}
+
+		// the fallback when partitioning keeps going badly, guarantees n log n
+		template <typename IteratorType, typename Predicate>
+		void heap_sort(IteratorType begin, IteratorType end, Predicate p)
+		{
+			const auto size = static_cast<size_t>(end - begin);
+
+			for (auto i = size / 2; i-- > 0; )
+				sift_down(begin, size, i, crt::move(*(begin + i)), p);
+
+			for (auto heap_size = size; heap_size > 1; )
+			{
+				--heap_size;
+				auto value = crt::move(*(begin + heap_size));
+				*(begin + heap_size) = crt::move(*begin);
+				sift_down(begin, heap_size, 0, crt::move(value), p);
+			}
+		}
+
+		// partitions around *begin into [elements before the pivot][pivot][elements not before it].
+		// expects an element that does not go before the pivot somewhere after begin, the median selection makes sure of that
+		template <typename IteratorType, typename Predicate>
+		partition_result<IteratorType> partition_right(IteratorType begin, IteratorType end, Predicate p)
+		{
+			auto pivot = crt::move(*begin);
+			auto first = begin;
+			auto last = end;
+
+			// the first pair of misplaced elements, the right scan is unguarded unless nothing stopped the left one
+			while (p(pivot, *++first));
+
+			if (first - 1 == begin)
+				while (first < last && !p(pivot, *--last));
+			else
+				while (!p(pivot, *--last));
+
+			const bool already_partitioned = first >= last;
+
+			while (first < last)
+			{
+				crt::swap(*first, *last);
+				while (p(pivot, *++first));
+				while (!p(pivot, *--last));
+			}
+
+			const auto pivot_position = first - 1;
+			*begin = crt::move(*pivot_position);
+			*pivot_position = crt::move(pivot);
+			return { pivot_position, already_partitioned };
+		}
+
+		// swaps num pairs of misplaced elements found by the block partition. with unequal counts a cycle of moves
+		// replaces the swaps, the leftover elements are handled in the next round
+		template <typename IteratorType>
+		void swap_block_offsets(IteratorType first, IteratorType last, const uint8_t* offsets_left, const uint8_t* offsets_right,
+			size_t num, bool use_swaps)
+		{
+			if (use_swaps)
+			{
+				for (size_t i = 0; i < num; ++i)
+					crt::swap(*(first + offsets_left[i]), *(last - offsets_right[i]));
+
+				return;
+			}
+
+			if (!num)
+				return;
+
+			auto left = first + offsets_left[0];
+			auto right = last - offsets_right[0];
+			auto value = crt::move(*left);
+			*left = crt::move(*right);
+
+			for (size_t i = 1; i < num; ++i)
+			{
+				left = first + offsets_left[i];
+				*right = crt::move(*left);
+				right = last - offsets_right[i];
+				*left = crt::move(*right);
+			}
+
+			*right = crt::move(value);
+		}
+
+		// partition_right for cheap comparisons: blocks of elements are classified first, writing the offsets of misplaced
+		// ones without a branch, then the misplaced elements are swapped. no mispredicted branch per element.
+		template <typename IteratorType, typename Predicate>
+		partition_result<IteratorType> partition_right_block(IteratorType begin, IteratorType end, Predicate p)
+		{
+			auto pivot = crt::move(*begin);
+			auto first = begin;
+			auto last = end;
+
+			while (p(pivot, *++first));
+
+			if (first - 1 == begin)
+				while (first < last && !p(pivot, *--last));
+			else
+				while (!p(pivot, *--last));
+
+			const bool already_partitioned = first >= last;
+			if (!already_partitioned)
+			{
+				crt::swap(*first, *last);
+				++first;
+
+				uint8_t offsets_left[sort_block_size];
+				uint8_t offsets_right[sort_block_size];
+
+				auto offsets_left_base = first;
+				auto offsets_right_base = last;
+				size_t num_left = 0;
+				size_t num_right = 0;
+				size_t start_left = 0;
+				size_t start_right = 0;
+
+				while (first < last)
+				{
+					// fill whichever offset buffers are empty, splitting what is left when both are
+					const auto num_unknown = static_cast<size_t>(last - first);
+					const auto left_split = num_left == 0 ? (num_right == 0 ? num_unknown / 2 : num_unknown) : 0;
+					const auto right_split = num_right == 0 ? num_unknown - left_split : 0;
+
+					const auto left_count = left_split < sort_block_size ? left_split : sort_block_size;
+					for (size_t i = 0; i < left_count; ++i)
+					{
+						offsets_left[num_left] = static_cast<uint8_t>(i);
+						num_left += !p(pivot, *first);
+						++first;
+					}
+
+					const auto right_count = right_split < sort_block_size ? right_split : sort_block_size;
+					for (size_t i = 0; i < right_count; )
+					{
+						offsets_right[num_right] = static_cast<uint8_t>(++i);
+						num_right += p(pivot, *--last);
+					}
+
+					const auto num = num_left < num_right ? num_left : num_right;
+					swap_block_offsets(offsets_left_base, offsets_right_base, offsets_left + start_left, offsets_right + start_right,
+						num, num_left == num_right);
+
+					num_left -= num;
+					num_right -= num;
+					start_left += num;
+					start_right += num;
+
+					if (num_left == 0)
+					{
+						start_left = 0;
+						offsets_left_base = first;
+					}
+
+					if (num_right == 0)
+					{
+						start_right = 0;
+						offsets_right_base = last;
+					}
+				}
+
+				// one side still has misplaced elements, move them next to the partition point
+				if (num_left)
+				{
+					while (num_left--)
+						crt::swap(*(offsets_left_base + offsets_left[start_left + num_left]), *--last);
+
+					first = last;
+				}
+
+				if (num_right)
+				{
+					while (num_right--)
+					{
+						crt::swap(*(offsets_right_base - offsets_right[start_right + num_right]), *first);
+						++first;
+					}
+
+					last = first;
+				}
+			}
+
+			const auto pivot_position = first - 1;
+			*begin = crt::move(*pivot_position);
+			*pivot_position = crt::move(pivot);
+			return { pivot_position, already_partitioned };
+		}
+
+		// partitions into [elements equal to the pivot][elements after it], returns the last equal one.
+		// used when the element before the range equals the pivot: the equal elements are then already in place
+		template <typename IteratorType, typename Predicate>
+		IteratorType partition_left(IteratorType begin, IteratorType end, Predicate p)
+		{
+			auto pivot = crt::move(*begin);
+			auto first = begin;
+			auto last = end;
+
+			while (p(*--last, pivot));
+
+			if (last + 1 == end)
+				while (first < last && !p(*++first, pivot));
+			else
+				while (!p(*++first, pivot));
+
+			while (first < last)
+			{
+				crt::swap(*first, *last);
+				while (p(*--last, pivot));
+				while (!p(*++first, pivot));
+			}
+
+			*begin = crt::move(*last);
+			*last = crt::move(pivot);
+			return last;
+		}
+
+		template <typename IteratorType, typename Predicate>
+		partition_result<IteratorType> partition_pivot(IteratorType begin, IteratorType end, Predicate p)
+		{
+			if constexpr (is_block_partitioned_v<sort_value_t<IteratorType>>)
+				return partition_right_block(begin, end, p);
+			else
+				return partition_right(begin, end, p);
+		}
+
+		// pattern-defeating quicksort. bad_allowed is how many highly unbalanced partitions are tolerated before
+		// switching to heap sort, leftmost is false if the element before begin bounds the range from below.
+		template <typename IteratorType, typename Predicate>
+		void introsort(IteratorType begin, IteratorType end, Predicate p, size_t bad_allowed, bool leftmost)
+		{
+			for (;;)
+			{
+				const auto size = static_cast<size_t>(end - begin);
+				if (size < sort_insertion_threshold)
+				{
+					if (leftmost)
+						insertion_sort(begin, end, p);
+					else
+						unguarded_insertion_sort(begin, end, p);
+
+					return;
+				}
+
+				// the pivot goes to begin, end - 1 gets an element that does not go before it
+				const auto half = size / 2;
+				if (size > sort_ninther_threshold)
+				{
+					sort3(begin, begin + half, end - 1, p);
+					sort3(begin + 1, begin + (half - 1), end - 2, p);
+					sort3(begin + 2, begin + (half + 1), end - 3, p);
+					sort3(begin + (half - 1), begin + half, begin + (half + 1), p);
+					crt::swap(*begin, *(begin + half));
+				}
+				else
+				{
+					sort3(begin + half, begin, end - 1, p);
+				}
+
+				// the pivot equals the element before the range, nothing in the range goes before it.
+				// put the elements equal to it aside, lots of duplicates get sorted in linear time
+				if (!leftmost && !p(*begin, *(begin - 1)))
+				{
+					begin = partition_left(begin, end, p) + 1;
+					continue;
+				}
+
+				const auto result = partition_pivot(begin, end, p);
+				const auto pivot = result.pivot;
+				const auto left_size = static_cast<size_t>(pivot - begin);
+				const auto right_size = static_cast<size_t>(end - (pivot + 1));
+
+				if (left_size < size / 8 || right_size < size / 8)
+				{
+					if (--bad_allowed == 0)
+					{
+						heap_sort(begin, end, p);
+						return;
+					}
+
+					// shuffle a few elements around to break the pattern that produced the bad pivot
+					if (left_size >= sort_insertion_threshold)
+					{
+						const auto quarter = left_size / 4;
+						crt::swap(*begin, *(begin + quarter));
+						crt::swap(*(pivot - 1), *(pivot - quarter));
+
+						if (left_size > sort_ninther_threshold)
+						{
+							crt::swap(*(begin + 1), *(begin + (quarter + 1)));
+							crt::swap(*(begin + 2), *(begin + (quarter + 2)));
+							crt::swap(*(pivot - 2), *(pivot - (quarter + 1)));
+							crt::swap(*(pivot - 3), *(pivot - (quarter + 2)));
+						}
+					}
+
+					if (right_size >= sort_insertion_threshold)
+					{
+						const auto quarter = right_size / 4;
+						crt::swap(*(pivot + 1), *(pivot + (1 + quarter)));
+						crt::swap(*(end - 1), *(end - quarter));
+
+						if (right_size > sort_ninther_threshold)
+						{
+							crt::swap(*(pivot + 2), *(pivot + (2 + quarter)));
+							crt::swap(*(pivot + 3), *(pivot + (3 + quarter)));
+							crt::swap(*(end - 2), *(end - (1 + quarter)));
+							crt::swap(*(end - 3), *(end - (2 + quarter)));
+						}
+					}
+				}
+				else if (result.already_partitioned && partial_insertion_sort(begin, pivot, p) && partial_insertion_sort(pivot + 1, end, p))
+				{
+					// a balanced partition that moved nothing, the input was likely sorted already
+					return;
+				}
+
+				// recurse into the smaller side and loop on the larger one, the stack stays within log n frames
+				if (left_size < right_size)
+				{
+					introsort(begin, pivot, p, bad_allowed, leftmost);
+					begin = pivot + 1;
+					leftmost = false;
+				}
+				else
+				{
+					introsort(pivot + 1, end, p, bad_allowed, false);
+					end = pivot;
+				}
+			}
+		}
+
+		inline size_t sort_log2(size_t value)
+		{
+			size_t log = 0;
+			while (value >>= 1)
+				++log;
+
+			return log;
 		}
 	}
 
+	// not stable. O(n log n) worst case, linear on sorted, reversed and all equal input
 	template <typename IteratorType, typename Predicate>
 	auto sort(IteratorType begin, IteratorType end, Predicate p)
 	{
-		quicksort(begin, end, p);
+		if (begin == end)
+			return;
+
+		detail::introsort(begin, end, p, detail::sort_log2(static_cast<size_t>(end - begin)), true);
 	}
 
 	template <typename Container, typename F, typename T = typename Container::value_type>
@@ -84,4 +526,4 @@ namespace crt
 			return scalar(lhs) < scalar(rhs);
 		});
 	}
-}
\ No newline at end of file
+}
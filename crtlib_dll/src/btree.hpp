@@ -0,0 +1,997 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <emmintrin.h>
+#if defined(__AVX__)
+#include <nmmintrin.h>
+#endif
+
+#include "assert.h"
+#include "my_memory.h"
+#include "my_vector.hpp"
+#include "iterator.hpp"
+#include "pair.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		// number of keys in the array that are less than key, compared 4 (or 2) keys at a time.
+		// a lane of the compare mask is -1 for every smaller key, subtracting the masks counts them per lane.
+		// unsigned keys are biased by the sign bit since sse only has signed compares.
+		template <typename K>
+		size_t simd_count_less(const K* keys, size_t count, K key)
+		{
+			size_t result = 0;
+			size_t i = 0;
+
+			if constexpr (sizeof(K) == 4)
+			{
+				const auto bias = _mm_set1_epi32(std::is_signed_v<K> ? 0 : static_cast<int32_t>(0x80000000));
+				const auto needle = _mm_xor_si128(_mm_set1_epi32(static_cast<int32_t>(key)), bias);
+				auto counts = _mm_setzero_si128();
+
+				for (; i + 4 <= count; i += 4)
+				{
+					const auto block = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), bias);
+					counts = _mm_sub_epi32(counts, _mm_cmpgt_epi32(needle, block));
+				}
+
+				counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(1, 0, 3, 2)));
+				counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(2, 3, 0, 1)));
+				result = static_cast<size_t>(_mm_cvtsi128_si32(counts));
+			}
+#if defined(__AVX__)
+			else if constexpr (sizeof(K) == 8)
+			{
+				const auto bias = _mm_set1_epi64x(std::is_signed_v<K> ? 0 : static_cast<int64_t>(0x8000000000000000ull));
+				const auto needle = _mm_xor_si128(_mm_set1_epi64x(static_cast<int64_t>(key)), bias);
+				auto counts = _mm_setzero_si128();
+
+				for (; i + 2 <= count; i += 2)
+				{
+					const auto block = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i)), bias);
+					counts = _mm_sub_epi64(counts, _mm_cmpgt_epi64(needle, block));
+				}
+
+				counts = _mm_add_epi64(counts, _mm_unpackhi_epi64(counts, counts));
+				result = static_cast<size_t>(_mm_cvtsi128_si32(counts));
+			}
+#endif
+
+			for (; i < count; ++i)
+				result += keys[i] < key;
+
+			return result;
+		}
+
+		// index of the first key that is not less than key
+		template <typename K>
+		size_t btree_lower_bound(const K* keys, size_t count, const K& key)
+		{
+			if constexpr (std::is_integral_v<K> && (sizeof(K) == 4 || sizeof(K) == 8))
+			{
+				return simd_count_less(keys, count, key);
+			}
+			else
+			{
+				size_t first = 0;
+				while (count > 0)
+				{
+					const auto half = count / 2;
+					if (keys[first + half] < key)
+					{
+						first += half + 1;
+						count -= half + 1;
+					}
+					else
+					{
+						count = half;
+					}
+				}
+
+				return first;
+			}
+		}
+
+		struct btree_empty {};
+	}
+
+	// ordered map implemented as a B+tree. nodes are a few cache lines wide, so a lookup touches log_B(n) nodes
+	// instead of the log_2(n) of a binary tree, and integral keys are searched inside the node with sse compares.
+	// the values live in the leaves, which are linked so that range iteration is a linear walk.
+	//
+	// for (auto entry : map.range(10, 20)) // keys in [10, 20)
+	//     use(*entry.first(), *entry.second());
+	//
+	// keys need operator< and are compared for equality as !(a < b) && !(b < a).
+	// keys and values must be default constructible. iterators and value references are invalidated by insert and remove.
+	template <typename K, typename V>
+	class btree_map
+	{
+		constexpr static size_t cache_line_size = 64;
+		constexpr static size_t node_key_bytes = 4 * cache_line_size;
+
+	public:
+		// maximum number of keys in a node. for 4 byte keys a node holds 64 keys.
+		constexpr static size_t key_capacity = node_key_bytes / sizeof(K) >= 8 ? node_key_bytes / sizeof(K) : 8;
+
+	private:
+		// a node that is not the root never has fewer keys
+		constexpr static size_t min_keys = (key_capacity - 1) / 2;
+
+		// not over aligned, crt::alloc only guarantees 16 bytes
+		struct node
+		{
+			K keys[key_capacity]{};
+			uint32_t count{};
+			bool leaf{};
+		};
+
+		struct leaf_node : node
+		{
+			V values[key_capacity]{};
+			leaf_node* prev{};
+			leaf_node* next{};
+		};
+
+		struct inner_node : node
+		{
+			node* children[key_capacity + 1]{};
+		};
+
+		// returned by a node that was split, right is inserted after the node in its parent
+		struct split_result
+		{
+			K separator;
+			node* right;
+		};
+
+		template <bool Const>
+		struct iterator_base
+		{
+			using value_pointer = std::conditional_t<Const, const V*, V*>;
+
+			constexpr static auto tag()
+			{
+				return forward_iterator_tag{};
+			}
+
+			iterator_base(leaf_node* leaf, uint32_t index) : leaf_(leaf), index_(index) {}
+
+			crt::pair<const K*, value_pointer> operator*() const
+			{
+				return crt::make_pair(static_cast<const K*>(&leaf_->keys[index_]), static_cast<value_pointer>(&leaf_->values[index_]));
+			}
+
+			const K& key() const { return leaf_->keys[index_]; }
+			auto& value() const { return *static_cast<value_pointer>(&leaf_->values[index_]); }
+
+			iterator_base& operator++()
+			{
+				if (++index_ == leaf_->count)
+				{
+					leaf_ = leaf_->next;
+					index_ = 0;
+				}
+
+				return *this;
+			}
+
+			iterator_base operator++(int) { iterator_base tmp = *this; ++(*this); return tmp; }
+
+			friend bool operator== (const iterator_base& a, const iterator_base& b) { return a.leaf_ == b.leaf_ && a.index_ == b.index_; }
+			friend bool operator!= (const iterator_base& a, const iterator_base& b) { return !(a == b); }
+
+		private:
+			friend class btree_map;
+
+			leaf_node* leaf_;
+			uint32_t index_;
+		};
+
+	public:
+		using iterator = iterator_base<false>;
+		using const_iterator = iterator_base<true>;
+
+		template <typename It>
+		struct range_view
+		{
+			It first;
+			It last;
+
+			It begin() const { return first; }
+			It end() const { return last; }
+		};
+
+		btree_map() = default;
+
+		btree_map(std::initializer_list<crt::pair<K, V>> args)
+		{
+			for (const auto& elem : args)
+				insert(elem.first(), elem.second());
+		}
+
+		btree_map(const btree_map& rhs)
+		{
+			vector<crt::pair<K, V>> entries(rhs.size());
+			for (auto entry : rhs)
+				entries.push_back(crt::make_pair(*entry.first(), *entry.second()));
+
+			assign_sorted(entries.data(), entries.size());
+		}
+
+		btree_map(btree_map&& rhs) noexcept
+		{
+			swap(*this, rhs);
+		}
+
+		btree_map& operator=(btree_map rhs)
+		{
+			swap(*this, rhs);
+			return *this;
+		}
+
+		~btree_map()
+		{
+			clear();
+		}
+
+		friend void swap(btree_map& lhs, btree_map& rhs) noexcept
+		{
+			crt::swap(lhs.root_, rhs.root_);
+			crt::swap(lhs.first_leaf_, rhs.first_leaf_);
+			crt::swap(lhs.last_leaf_, rhs.last_leaf_);
+			crt::swap(lhs.size_, rhs.size_);
+		}
+
+		// replace the contents with entries, which must be sorted by strictly increasing key.
+		// the leaves are filled almost completely and the inner levels are built bottom up, O(n).
+		void assign_sorted(const crt::pair<K, V>* entries, size_t count)
+		{
+			clear();
+			if (!count)
+				return;
+
+			vector<node*> level(count / key_capacity + 1);
+			vector<K> level_first_keys(count / key_capacity + 1);
+
+			// spread the entries evenly, so that no leaf ends up below min_keys
+			const auto leaf_count = (count + key_capacity - 1) / key_capacity;
+			size_t entry_index = 0;
+
+			for (size_t l = 0; l < leaf_count; ++l)
+			{
+				const auto leaf_size = count / leaf_count + (l < count % leaf_count);
+				auto leaf = new leaf_node{};
+				leaf->leaf = true;
+				leaf->count = static_cast<uint32_t>(leaf_size);
+
+				for (size_t i = 0; i < leaf_size; ++i, ++entry_index)
+				{
+					CRT_ASSERT(!entry_index || entries[entry_index - 1].first() < entries[entry_index].first(), "btree_map::assign_sorted input is not sorted!");
+					leaf->keys[i] = entries[entry_index].first();
+					leaf->values[i] = entries[entry_index].second();
+				}
+
+				leaf->prev = last_leaf_;
+				if (last_leaf_)
+					last_leaf_->next = leaf;
+				else
+					first_leaf_ = leaf;
+				last_leaf_ = leaf;
+
+				level.push_back(leaf);
+				level_first_keys.push_back(leaf->keys[0]);
+			}
+
+			// group the nodes of a level under parents until a single root remains
+			while (level.size() > 1)
+			{
+				constexpr auto max_children = key_capacity + 1;
+				const auto parent_count = (level.size() + max_children - 1) / max_children;
+
+				vector<node*> parents(parent_count);
+				vector<K> parent_first_keys(parent_count);
+				size_t child_index = 0;
+
+				for (size_t p = 0; p < parent_count; ++p)
+				{
+					const auto children = level.size() / parent_count + (p < level.size() % parent_count);
+					auto parent = new inner_node{};
+					parent->count = static_cast<uint32_t>(children - 1);
+
+					parent_first_keys.push_back(level_first_keys[child_index]);
+					for (size_t c = 0; c < children; ++c, ++child_index)
+					{
+						parent->children[c] = level[child_index];
+						if (c)
+							parent->keys[c - 1] = level_first_keys[child_index];
+					}
+
+					parents.push_back(parent);
+				}
+
+				level = crt::move(parents);
+				level_first_keys = crt::move(parent_first_keys);
+			}
+
+			root_ = level[0];
+			size_ = count;
+		}
+
+		// insert key/value, overwriting the value if the key already exists
+		V& insert(K key, V value)
+		{
+			bool inserted;
+			auto& result = find_or_insert(crt::move(key), inserted);
+			result = crt::move(value);
+			return result;
+		}
+
+		// returns the value by ref if key exists, otherwise inserts a default value and returns it by ref.
+		V& find_or_insert(const K& key)
+		{
+			bool inserted;
+			return find_or_insert(key, inserted);
+		}
+
+		V& operator[](const K& key)
+		{
+			return find_or_insert(key);
+		}
+
+		// find value by key, returns nullptr if the key does not exist
+		V* find_value(const K& key)
+		{
+			const auto it = find_position(key);
+			return it.leaf_ ? &it.leaf_->values[it.index_] : nullptr;
+		}
+
+		const V* find_value(const K& key) const
+		{
+			const auto it = find_position(key);
+			return it.leaf_ ? &it.leaf_->values[it.index_] : nullptr;
+		}
+
+		bool contains(const K& key) const
+		{
+			return find_position(key).leaf_ != nullptr;
+		}
+
+		// remove key/value pair if it exists, returns whether it existed
+		bool remove(const K& key)
+		{
+			if (!root_ || !remove_from(root_, key))
+				return false;
+
+			--size_;
+
+			if (!root_->count)
+			{
+				auto old_root = root_;
+				if (root_->leaf)
+				{
+					root_ = nullptr;
+					first_leaf_ = last_leaf_ = nullptr;
+				}
+				else
+				{
+					root_ = as_inner(root_)->children[0];
+				}
+
+				free_node(old_root);
+			}
+
+			return true;
+		}
+
+		void clear()
+		{
+			if (root_)
+				free_subtree(root_);
+
+			root_ = nullptr;
+			first_leaf_ = last_leaf_ = nullptr;
+			size_ = 0;
+		}
+
+		// first element whose key is not less than key
+		iterator lower_bound(const K& key)
+		{
+			return lower_bound_position(key);
+		}
+
+		const_iterator lower_bound(const K& key) const
+		{
+			const auto it = lower_bound_position(key);
+			return const_iterator(it.leaf_, it.index_);
+		}
+
+		// first element whose key is greater than key
+		iterator upper_bound(const K& key)
+		{
+			return upper_bound_position(key);
+		}
+
+		const_iterator upper_bound(const K& key) const
+		{
+			const auto it = upper_bound_position(key);
+			return const_iterator(it.leaf_, it.index_);
+		}
+
+		// elements with keys in [first, last)
+		range_view<iterator> range(const K& first, const K& last)
+		{
+			if (!(first < last))
+				return { end(), end() };
+
+			return { lower_bound(first), lower_bound(last) };
+		}
+
+		range_view<const_iterator> range(const K& first, const K& last) const
+		{
+			if (!(first < last))
+				return { end(), end() };
+
+			return { lower_bound(first), lower_bound(last) };
+		}
+
+		// in increasing key order
+		iterator begin() { return iterator(first_leaf_, 0); }
+		iterator end() { return iterator(nullptr, 0); }
+		const_iterator begin() const { return const_iterator(first_leaf_, 0); }
+		const_iterator end() const { return const_iterator(nullptr, 0); }
+
+		size_t size() const
+		{
+			return size_;
+		}
+
+		bool empty() const
+		{
+			return size_ == 0;
+		}
+
+	private:
+		static leaf_node* as_leaf(node* n)
+		{
+			return static_cast<leaf_node*>(n);
+		}
+
+		static inner_node* as_inner(node* n)
+		{
+			return static_cast<inner_node*>(n);
+		}
+
+		// index of the child of an inner node that can contain key
+		static size_t child_index(const node* n, const K& key)
+		{
+			// separator keys[i] is the smallest key of children[i + 1]
+			const auto idx = detail::btree_lower_bound(n->keys, n->count, key);
+			return idx < n->count && !(key < n->keys[idx]) ? idx + 1 : idx;
+		}
+
+		leaf_node* find_leaf(const K& key) const
+		{
+			auto n = root_;
+			while (!n->leaf)
+				n = as_inner(n)->children[child_index(n, key)];
+
+			return as_leaf(n);
+		}
+
+		// position of key, or end() if it does not exist
+		iterator find_position(const K& key) const
+		{
+			if (!root_)
+				return iterator(nullptr, 0);
+
+			const auto leaf = find_leaf(key);
+			const auto idx = detail::btree_lower_bound(leaf->keys, leaf->count, key);
+			if (idx < leaf->count && !(key < leaf->keys[idx]))
+				return iterator(leaf, static_cast<uint32_t>(idx));
+
+			return iterator(nullptr, 0);
+		}
+
+		iterator lower_bound_position(const K& key) const
+		{
+			if (!root_)
+				return iterator(nullptr, 0);
+
+			const auto leaf = find_leaf(key);
+			const auto idx = detail::btree_lower_bound(leaf->keys, leaf->count, key);
+
+			// every key of the next leaf is at least the separator, which is greater than key
+			if (idx == leaf->count)
+				return iterator(leaf->next, 0);
+
+			return iterator(leaf, static_cast<uint32_t>(idx));
+		}
+
+		iterator upper_bound_position(const K& key) const
+		{
+			auto it = lower_bound_position(key);
+			if (it.leaf_ && !(key < it.key()))
+				++it;
+
+			return it;
+		}
+
+		V& find_or_insert(K key, bool& inserted)
+		{
+			if (!root_)
+			{
+				auto leaf = new leaf_node{};
+				leaf->leaf = true;
+				root_ = first_leaf_ = last_leaf_ = leaf;
+			}
+
+			V* value = nullptr;
+			inserted = false;
+
+			split_result split;
+			if (insert_into(root_, key, value, inserted, split))
+			{
+				// the root was split, the tree grows by one level
+				auto new_root = new inner_node{};
+				new_root->count = 1;
+				new_root->keys[0] = crt::move(split.separator);
+				new_root->children[0] = root_;
+				new_root->children[1] = split.right;
+				root_ = new_root;
+			}
+
+			if (inserted)
+				++size_;
+
+			return *value;
+		}
+
+		// returns true if n was split, in which case split is filled
+		bool insert_into(node* n, const K& key, V*& value, bool& inserted, split_result& split)
+		{
+			if (n->leaf)
+				return insert_into_leaf(as_leaf(n), key, value, inserted, split);
+
+			auto inner = as_inner(n);
+			const auto idx = child_index(inner, key);
+
+			split_result child_split;
+			if (!insert_into(inner->children[idx], key, value, inserted, child_split))
+				return false;
+
+			if (inner->count < key_capacity)
+			{
+				insert_child(inner, idx, crt::move(child_split.separator), child_split.right);
+				return false;
+			}
+
+			// split the full inner node, the middle key moves up to the parent
+			const uint32_t middle = key_capacity / 2;
+			auto right = new inner_node{};
+			right->count = static_cast<uint32_t>(key_capacity - middle - 1);
+
+			for (uint32_t i = 0; i < right->count; ++i)
+				right->keys[i] = crt::move(inner->keys[middle + 1 + i]);
+			for (uint32_t i = 0; i <= right->count; ++i)
+				right->children[i] = inner->children[middle + 1 + i];
+
+			split.separator = crt::move(inner->keys[middle]);
+			split.right = right;
+			inner->count = middle;
+
+			if (idx <= middle)
+				insert_child(inner, idx, crt::move(child_split.separator), child_split.right);
+			else
+				insert_child(right, idx - middle - 1, crt::move(child_split.separator), child_split.right);
+
+			return true;
+		}
+
+		bool insert_into_leaf(leaf_node* leaf, const K& key, V*& value, bool& inserted, split_result& split)
+		{
+			auto idx = detail::btree_lower_bound(leaf->keys, leaf->count, key);
+			if (idx < leaf->count && !(key < leaf->keys[idx]))
+			{
+				value = &leaf->values[idx];
+				return false;
+			}
+
+			inserted = true;
+
+			if (leaf->count < key_capacity)
+			{
+				value = insert_entry(leaf, idx, key);
+				return false;
+			}
+
+			// split the full leaf in half and insert into the half that covers the key
+			const uint32_t middle = key_capacity / 2;
+			auto right = new leaf_node{};
+			right->leaf = true;
+			right->count = static_cast<uint32_t>(key_capacity - middle);
+
+			for (uint32_t i = 0; i < right->count; ++i)
+			{
+				right->keys[i] = crt::move(leaf->keys[middle + i]);
+				right->values[i] = crt::move(leaf->values[middle + i]);
+			}
+
+			leaf->count = middle;
+
+			right->prev = leaf;
+			right->next = leaf->next;
+			if (leaf->next)
+				leaf->next->prev = right;
+			else
+				last_leaf_ = right;
+			leaf->next = right;
+
+			if (idx <= middle)
+				value = insert_entry(leaf, idx, key);
+			else
+				value = insert_entry(right, idx - middle, key);
+
+			split.separator = right->keys[0];
+			split.right = right;
+			return true;
+		}
+
+		static V* insert_entry(leaf_node* leaf, size_t idx, const K& key)
+		{
+			for (size_t i = leaf->count; i > idx; --i)
+			{
+				leaf->keys[i] = crt::move(leaf->keys[i - 1]);
+				leaf->values[i] = crt::move(leaf->values[i - 1]);
+			}
+
+			leaf->keys[idx] = key;
+			leaf->values[idx] = V{};
+			++leaf->count;
+			return &leaf->values[idx];
+		}
+
+		// insert separator and the child to its right after children[idx]
+		static void insert_child(inner_node* inner, size_t idx, K separator, node* child)
+		{
+			for (size_t i = inner->count; i > idx; --i)
+			{
+				inner->keys[i] = crt::move(inner->keys[i - 1]);
+				inner->children[i + 1] = inner->children[i];
+			}
+
+			inner->keys[idx] = crt::move(separator);
+			inner->children[idx + 1] = child;
+			++inner->count;
+		}
+
+		// returns whether the key was removed. children that fall below min_keys are refilled by the caller.
+		bool remove_from(node* n, const K& key)
+		{
+			if (n->leaf)
+			{
+				auto leaf = as_leaf(n);
+				const auto idx = detail::btree_lower_bound(leaf->keys, leaf->count, key);
+				if (idx == leaf->count || key < leaf->keys[idx])
+					return false;
+
+				// separators equal to the removed key stay valid, they still split the subtrees correctly
+				for (size_t i = idx + 1; i < leaf->count; ++i)
+				{
+					leaf->keys[i - 1] = crt::move(leaf->keys[i]);
+					leaf->values[i - 1] = crt::move(leaf->values[i]);
+				}
+
+				--leaf->count;
+				return true;
+			}
+
+			auto inner = as_inner(n);
+			const auto idx = child_index(inner, key);
+			if (!remove_from(inner->children[idx], key))
+				return false;
+
+			if (inner->children[idx]->count < min_keys)
+				rebalance(inner, idx);
+
+			return true;
+		}
+
+		// refill children[idx] by borrowing a key from a sibling, or merge it with a sibling if both are small
+		void rebalance(inner_node* parent, size_t idx)
+		{
+			auto left = idx > 0 ? parent->children[idx - 1] : nullptr;
+			auto right = idx < parent->count ? parent->children[idx + 1] : nullptr;
+
+			if (left && left->count > min_keys)
+			{
+				borrow_from_left(parent, idx);
+			}
+			else if (right && right->count > min_keys)
+			{
+				borrow_from_right(parent, idx);
+			}
+			else if (left)
+			{
+				merge(parent, idx - 1);
+			}
+			else if (right)
+			{
+				merge(parent, idx);
+			}
+		}
+
+		static void borrow_from_left(inner_node* parent, size_t idx)
+		{
+			auto child = parent->children[idx];
+			auto left = parent->children[idx - 1];
+
+			for (size_t i = child->count; i > 0; --i)
+				child->keys[i] = crt::move(child->keys[i - 1]);
+
+			if (child->leaf)
+			{
+				auto child_leaf = as_leaf(child);
+				auto left_leaf = as_leaf(left);
+
+				for (size_t i = child->count; i > 0; --i)
+					child_leaf->values[i] = crt::move(child_leaf->values[i - 1]);
+
+				child_leaf->keys[0] = crt::move(left_leaf->keys[left->count - 1]);
+				child_leaf->values[0] = crt::move(left_leaf->values[left->count - 1]);
+				parent->keys[idx - 1] = child_leaf->keys[0];
+			}
+			else
+			{
+				auto child_inner = as_inner(child);
+				auto left_inner = as_inner(left);
+
+				for (size_t i = child->count + 1; i > 0; --i)
+					child_inner->children[i] = child_inner->children[i - 1];
+
+				// rotate through the parent: the separator moves down, the last key of the left sibling moves up
+				child_inner->keys[0] = crt::move(parent->keys[idx - 1]);
+				child_inner->children[0] = left_inner->children[left->count];
+				parent->keys[idx - 1] = crt::move(left_inner->keys[left->count - 1]);
+			}
+
+			++child->count;
+			--left->count;
+		}
+
+		static void borrow_from_right(inner_node* parent, size_t idx)
+		{
+			auto child = parent->children[idx];
+			auto right = parent->children[idx + 1];
+
+			if (child->leaf)
+			{
+				auto child_leaf = as_leaf(child);
+				auto right_leaf = as_leaf(right);
+
+				child_leaf->keys[child->count] = crt::move(right_leaf->keys[0]);
+				child_leaf->values[child->count] = crt::move(right_leaf->values[0]);
+
+				for (size_t i = 1; i < right->count; ++i)
+				{
+					right_leaf->keys[i - 1] = crt::move(right_leaf->keys[i]);
+					right_leaf->values[i - 1] = crt::move(right_leaf->values[i]);
+				}
+
+				parent->keys[idx] = right_leaf->keys[0];
+			}
+			else
+			{
+				auto child_inner = as_inner(child);
+				auto right_inner = as_inner(right);
+
+				child_inner->keys[child->count] = crt::move(parent->keys[idx]);
+				child_inner->children[child->count + 1] = right_inner->children[0];
+				parent->keys[idx] = crt::move(right_inner->keys[0]);
+
+				for (size_t i = 1; i < right->count; ++i)
+					right_inner->keys[i - 1] = crt::move(right_inner->keys[i]);
+				for (size_t i = 1; i <= right->count; ++i)
+					right_inner->children[i - 1] = right_inner->children[i];
+			}
+
+			++child->count;
+			--right->count;
+		}
+
+		// merge children[idx + 1] into children[idx] and remove it from the parent
+		void merge(inner_node* parent, size_t idx)
+		{
+			auto left = parent->children[idx];
+			auto right = parent->children[idx + 1];
+
+			if (left->leaf)
+			{
+				auto left_leaf = as_leaf(left);
+				auto right_leaf = as_leaf(right);
+
+				for (size_t i = 0; i < right->count; ++i)
+				{
+					left_leaf->keys[left->count + i] = crt::move(right_leaf->keys[i]);
+					left_leaf->values[left->count + i] = crt::move(right_leaf->values[i]);
+				}
+
+				left->count += right->count;
+
+				left_leaf->next = right_leaf->next;
+				if (right_leaf->next)
+					right_leaf->next->prev = left_leaf;
+				else
+					last_leaf_ = left_leaf;
+			}
+			else
+			{
+				auto left_inner = as_inner(left);
+				auto right_inner = as_inner(right);
+
+				// the separator moves down between the keys of both nodes
+				left_inner->keys[left->count] = crt::move(parent->keys[idx]);
+				for (size_t i = 0; i < right->count; ++i)
+					left_inner->keys[left->count + 1 + i] = crt::move(right_inner->keys[i]);
+				for (size_t i = 0; i <= right->count; ++i)
+					left_inner->children[left->count + 1 + i] = right_inner->children[i];
+
+				left->count += right->count + 1;
+			}
+
+			for (size_t i = idx + 1; i < parent->count; ++i)
+			{
+				parent->keys[i - 1] = crt::move(parent->keys[i]);
+				parent->children[i] = parent->children[i + 1];
+			}
+
+			--parent->count;
+			free_node(right);
+		}
+
+		static void free_node(node* n)
+		{
+			if (n->leaf)
+				delete as_leaf(n);
+			else
+				delete as_inner(n);
+		}
+
+		static void free_subtree(node* n)
+		{
+			if (!n->leaf)
+			{
+				auto inner = as_inner(n);
+				for (size_t i = 0; i <= inner->count; ++i)
+					free_subtree(inner->children[i]);
+			}
+
+			free_node(n);
+		}
+
+		node* root_{};
+		leaf_node* first_leaf_{};
+		leaf_node* last_leaf_{};
+		size_t size_{};
+	};
+
+	// ordered set implemented as a B+tree, see btree_map.
+	template <typename T>
+	class btree_set
+	{
+		using t_map = btree_map<T, detail::btree_empty>;
+
+	public:
+		using value_type = T;
+
+		struct const_iterator
+		{
+			constexpr static auto tag()
+			{
+				return forward_iterator_tag{};
+			}
+
+			const_iterator(typename t_map::const_iterator it) : map_iterator_(it) {}
+
+			const T& operator*() const
+			{
+				return map_iterator_.key();
+			}
+
+			const_iterator& operator++()
+			{
+				++map_iterator_;
+				return *this;
+			}
+
+			const_iterator operator++(int) { const_iterator tmp = *this; ++(*this); return tmp; }
+
+			friend bool operator== (const const_iterator& a, const const_iterator& b) { return a.map_iterator_ == b.map_iterator_; }
+			friend bool operator!= (const const_iterator& a, const const_iterator& b) { return a.map_iterator_ != b.map_iterator_; }
+
+		private:
+			typename t_map::const_iterator map_iterator_;
+		};
+
+		btree_set() = default;
+
+		btree_set(std::initializer_list<T> args)
+		{
+			for (const auto& elem : args)
+				add(elem);
+		}
+
+		// replace the contents with elements, which must be strictly increasing
+		void assign_sorted(const T* elements, size_t count)
+		{
+			vector<crt::pair<T, detail::btree_empty>> entries(count);
+			for (size_t i = 0; i < count; ++i)
+				entries.push_back(crt::make_pair(elements[i], detail::btree_empty{}));
+
+			map_.assign_sorted(entries.data(), entries.size());
+		}
+
+		void push_back(T value)
+		{
+			add(crt::move(value));
+		}
+
+		void add(T value)
+		{
+			map_.find_or_insert(value);
+		}
+
+		bool remove(const T& value)
+		{
+			return map_.remove(value);
+		}
+
+		bool contains(const T& value) const
+		{
+			return map_.contains(value);
+		}
+
+		// first element that is not less than value
+		const_iterator lower_bound(const T& value) const
+		{
+			return map_.lower_bound(value);
+		}
+
+		// first element that is greater than value
+		const_iterator upper_bound(const T& value) const
+		{
+			return map_.upper_bound(value);
+		}
+
+		// elements in [first, last)
+		typename t_map::template range_view<const_iterator> range(const T& first, const T& last) const
+		{
+			const auto map_range = map_.range(first, last);
+			return { map_range.first, map_range.last };
+		}
+
+		// in increasing order
+		const_iterator begin() const { return map_.begin(); }
+		const_iterator end() const { return map_.end(); }
+
+		void clear()
+		{
+			map_.clear();
+		}
+
+		size_t size() const
+		{
+			return map_.size();
+		}
+
+		bool empty() const
+		{
+			return map_.empty();
+		}
+
+	private:
+		t_map map_{};
+	};
+}
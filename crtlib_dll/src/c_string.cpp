@@ -0,0 +1,546 @@
+#include "c_string.hpp"
+#include <cstdint>
+#include <intrin.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+namespace crt
+{
+	namespace detail
+	{
+		// an aligned load never crosses a page boundary, so reading past the null terminator inside it is safe
+		constexpr size_t page_size = 4096;
+
+		// needles longer than this are searched with two way, which is linear in the worst case
+		constexpr size_t two_way_threshold = 64;
+
+#if defined(__AVX2__)
+		using chunk = __m256i;
+		constexpr size_t chunk_size = 32;
+
+		static chunk load_aligned(const void* p) { return _mm256_load_si256(static_cast<const chunk*>(p)); }
+		static chunk load(const void* p) { return _mm256_loadu_si256(static_cast<const chunk*>(p)); }
+		static chunk zero_chunk() { return _mm256_setzero_si256(); }
+		static void store(void* p, chunk v) { _mm256_storeu_si256(static_cast<chunk*>(p), v); }
+		static chunk and_chunk(chunk a, chunk b) { return _mm256_and_si256(a, b); }
+		static chunk xor_chunk(chunk a, chunk b) { return _mm256_xor_si256(a, b); }
+		static uint32_t byte_mask(chunk v) { return static_cast<uint32_t>(_mm256_movemask_epi8(v)); }
+		constexpr uint32_t full_mask = 0xFFFFFFFF;
+
+		template <typename CharType>
+		static chunk splat(CharType c)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm256_set1_epi8(static_cast<char>(c));
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm256_set1_epi16(static_cast<short>(c));
+			else
+				return _mm256_set1_epi32(static_cast<int>(c));
+		}
+
+		template <typename CharType>
+		static chunk equal(chunk a, chunk b)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm256_cmpeq_epi8(a, b);
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm256_cmpeq_epi16(a, b);
+			else
+				return _mm256_cmpeq_epi32(a, b);
+		}
+
+		template <typename CharType>
+		static chunk add(chunk a, chunk b)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm256_add_epi8(a, b);
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm256_add_epi16(a, b);
+			else
+				return _mm256_add_epi32(a, b);
+		}
+
+		// signed a < b
+		template <typename CharType>
+		static chunk less(chunk a, chunk b)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm256_cmpgt_epi8(b, a);
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm256_cmpgt_epi16(b, a);
+			else
+				return _mm256_cmpgt_epi32(b, a);
+		}
+#else
+		using chunk = __m128i;
+		constexpr size_t chunk_size = 16;
+
+		static chunk load_aligned(const void* p) { return _mm_load_si128(static_cast<const chunk*>(p)); }
+		static chunk load(const void* p) { return _mm_loadu_si128(static_cast<const chunk*>(p)); }
+		static chunk zero_chunk() { return _mm_setzero_si128(); }
+		static void store(void* p, chunk v) { _mm_storeu_si128(static_cast<chunk*>(p), v); }
+		static chunk and_chunk(chunk a, chunk b) { return _mm_and_si128(a, b); }
+		static chunk xor_chunk(chunk a, chunk b) { return _mm_xor_si128(a, b); }
+		static uint32_t byte_mask(chunk v) { return static_cast<uint32_t>(_mm_movemask_epi8(v)); }
+		constexpr uint32_t full_mask = 0xFFFF;
+
+		template <typename CharType>
+		static chunk splat(CharType c)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm_set1_epi8(static_cast<char>(c));
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm_set1_epi16(static_cast<short>(c));
+			else
+				return _mm_set1_epi32(static_cast<int>(c));
+		}
+
+		template <typename CharType>
+		static chunk equal(chunk a, chunk b)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm_cmpeq_epi8(a, b);
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm_cmpeq_epi16(a, b);
+			else
+				return _mm_cmpeq_epi32(a, b);
+		}
+
+		template <typename CharType>
+		static chunk add(chunk a, chunk b)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm_add_epi8(a, b);
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm_add_epi16(a, b);
+			else
+				return _mm_add_epi32(a, b);
+		}
+
+		// signed a < b
+		template <typename CharType>
+		static chunk less(chunk a, chunk b)
+		{
+			if constexpr (sizeof(CharType) == 1)
+				return _mm_cmplt_epi8(a, b);
+			else if constexpr (sizeof(CharType) == 2)
+				return _mm_cmplt_epi16(a, b);
+			else
+				return _mm_cmplt_epi32(a, b);
+		}
+#endif
+
+		// masks are per byte, a matching character sets sizeof(CharType) consecutive bits
+		static uint32_t lowest_bit(uint32_t mask)
+		{
+			unsigned long index;
+			_BitScanForward(&index, mask);
+			return index;
+		}
+
+		template <typename CharType>
+		static uint32_t clear_character(uint32_t mask, uint32_t bit)
+		{
+			constexpr uint32_t character_bits = (1u << sizeof(CharType)) - 1;
+			return mask & ~(character_bits << bit);
+		}
+
+		static bool crosses_page(const void* p)
+		{
+			return (reinterpret_cast<uintptr_t>(p) & (page_size - 1)) > page_size - chunk_size;
+		}
+
+		template <typename CharType>
+		static int compare_characters(CharType a, CharType b)
+		{
+			if (a == b)
+				return 0;
+
+			return a > b ? 1 : -1;
+		}
+
+		// ascii letters from first to first + 25 get their case flipped, every other character is unchanged.
+		// the bias moves those letters to the bottom of the signed range, so one signed compare checks both bounds.
+		template <typename CharType>
+		static chunk flip_case(chunk v, CharType first)
+		{
+			constexpr uint32_t sign = 1u << (sizeof(CharType) * 8 - 1);
+			const auto biased = add<CharType>(v, splat(static_cast<CharType>(sign - first)));
+			const auto letters = less<CharType>(biased, splat(static_cast<CharType>(sign + 26)));
+			return xor_chunk(v, and_chunk(letters, splat(static_cast<CharType>(0x20))));
+		}
+
+		// the case insensitive searches compare characters folded to lower case
+		template <bool IgnoreCase, typename CharType>
+		static chunk fold_chunk(chunk v)
+		{
+			if constexpr (IgnoreCase)
+				return flip_case(v, static_cast<CharType>('A'));
+			else
+				return v;
+		}
+
+		template <bool IgnoreCase, typename CharType>
+		static CharType fold_character(CharType c)
+		{
+			if constexpr (IgnoreCase)
+				return to_lower_ascii(c);
+			else
+				return c;
+		}
+
+		template <typename CharType>
+		static void flip_case_chunked(const CharType* str, size_t size, CharType* out, CharType first)
+		{
+			constexpr size_t characters_per_chunk = chunk_size / sizeof(CharType);
+
+			// no overlapping last chunk, out may be str and the overlap would be flipped twice
+			size_t i = 0;
+			for (; i + characters_per_chunk <= size; i += characters_per_chunk)
+				store(out + i, flip_case(load(str + i), first));
+
+			for (; i < size; ++i)
+				out[i] = str[i] >= first && str[i] <= first + 25 ? static_cast<CharType>(str[i] ^ 0x20) : str[i];
+		}
+
+		template <typename CharType>
+		static bool iequal_chunked(const CharType* str1, const CharType* str2, size_t size)
+		{
+			constexpr size_t characters_per_chunk = chunk_size / sizeof(CharType);
+
+			size_t i = 0;
+			for (; i + characters_per_chunk <= size; i += characters_per_chunk)
+			{
+				const auto block1 = fold_chunk<true, CharType>(load(str1 + i));
+				const auto block2 = fold_chunk<true, CharType>(load(str2 + i));
+				if (byte_mask(equal<CharType>(block1, block2)) != full_mask)
+					return false;
+			}
+
+			for (; i < size; ++i)
+			{
+				if (to_lower_ascii(str1[i]) != to_lower_ascii(str2[i]))
+					return false;
+			}
+
+			return true;
+		}
+
+		template <bool IgnoreCase, typename CharType>
+		static bool equal_characters(const CharType* str1, const CharType* str2, size_t size)
+		{
+			if constexpr (IgnoreCase)
+				return iequal_chunked(str1, str2, size);
+			else
+				return !memcmp(str1, str2, size * sizeof(CharType));
+		}
+
+		template <typename CharType>
+		static size_t strlen_chunked(const CharType* p_str)
+		{
+			const auto address = reinterpret_cast<uintptr_t>(p_str);
+
+			// a misaligned wide string would split characters across the aligned chunks
+			if (address % sizeof(CharType))
+			{
+				size_t size = 0;
+				while (p_str[size])
+					++size;
+
+				return size;
+			}
+
+			// align down and drop the bytes in front of the string from the first mask
+			const auto offset = static_cast<uint32_t>(address & (chunk_size - 1));
+			auto block = reinterpret_cast<const uint8_t*>(address - offset);
+			const auto zero = zero_chunk();
+
+			auto mask = byte_mask(equal<CharType>(load_aligned(block), zero)) >> offset;
+			if (mask)
+				return lowest_bit(mask) / sizeof(CharType);
+
+			for (;;)
+			{
+				block += chunk_size;
+				mask = byte_mask(equal<CharType>(load_aligned(block), zero));
+				if (mask)
+					return (block + lowest_bit(mask) - reinterpret_cast<const uint8_t*>(p_str)) / sizeof(CharType);
+			}
+		}
+
+		template <typename CharType>
+		static int strcmp_chunked(const CharType* str1, const CharType* str2)
+		{
+			constexpr size_t characters_per_chunk = chunk_size / sizeof(CharType);
+			const auto zero = zero_chunk();
+
+			for (size_t i = 0; ; )
+			{
+				if (crosses_page(str1 + i) || crosses_page(str2 + i))
+				{
+					// step one character at a time until both strings are past the page boundary
+					if (str1[i] != str2[i] || str1[i] == 0)
+						return compare_characters(str1[i], str2[i]);
+
+					++i;
+					continue;
+				}
+
+				const auto block1 = load(str1 + i);
+				const auto block2 = load(str2 + i);
+
+				const auto different = ~byte_mask(equal<CharType>(block1, block2)) & full_mask;
+				const auto terminator = byte_mask(equal<CharType>(block1, zero));
+				const auto mask = different | terminator;
+				if (mask)
+				{
+					const auto index = i + lowest_bit(mask) / sizeof(CharType);
+					return compare_characters(str1[index], str2[index]);
+				}
+
+				i += characters_per_chunk;
+			}
+		}
+
+		// lexicographic maximal suffix of needle, for the ordering given by Less. returns its start, period is set to its period.
+		template <bool IgnoreCase, typename CharType, typename Less>
+		static size_t maximal_suffix(const CharType* needle, size_t size, size_t& period, Less less)
+		{
+			size_t suffix = ~size_t(0);	// -1, needle[suffix + k] wraps around to needle[k - 1]
+			size_t j = 0;
+			size_t k = 1;
+			period = 1;
+
+			while (j + k < size)
+			{
+				const auto a = fold_character<IgnoreCase>(needle[j + k]);
+				const auto b = fold_character<IgnoreCase>(needle[suffix + k]);
+
+				if (less(a, b))
+				{
+					j += k;
+					k = 1;
+					period = j - suffix;
+				}
+				else if (a == b)
+				{
+					if (k != period)
+					{
+						++k;
+					}
+					else
+					{
+						j += period;
+						k = 1;
+					}
+				}
+				else
+				{
+					suffix = j++;
+					k = period = 1;
+				}
+			}
+
+			return suffix + 1;
+		}
+
+		// crochemore-perrin two way search. O(n + m) time and O(1) space.
+		template <bool IgnoreCase, typename CharType>
+		static const CharType* two_way_find(const CharType* haystack, size_t haystack_size, const CharType* needle, size_t needle_size)
+		{
+			// critical factorization: the later of the two maximal suffixes
+			size_t period_less, period_greater;
+			const auto suffix_less = maximal_suffix<IgnoreCase>(needle, needle_size, period_less, [](CharType a, CharType b) { return a < b; });
+			const auto suffix_greater = maximal_suffix<IgnoreCase>(needle, needle_size, period_greater, [](CharType a, CharType b) { return a > b; });
+
+			const auto suffix = suffix_less > suffix_greater ? suffix_less : suffix_greater;
+			auto period = suffix_less > suffix_greater ? period_less : period_greater;
+
+			const auto last_start = haystack_size - needle_size;
+			const auto matches = [needle, haystack](size_t i, size_t j)
+			{
+				return fold_character<IgnoreCase>(needle[i]) == fold_character<IgnoreCase>(haystack[i + j]);
+			};
+
+			if (equal_characters<IgnoreCase>(needle, needle + period, suffix))
+			{
+				// periodic needle. after a full right half match, the characters already known to match
+				// one period further are not scanned again
+				size_t memory = 0;
+				for (size_t j = 0; j <= last_start; )
+				{
+					auto i = suffix > memory ? suffix : memory;
+					while (i < needle_size && matches(i, j))
+						++i;
+
+					if (i < needle_size)
+					{
+						j += i - suffix + 1;
+						memory = 0;
+						continue;
+					}
+
+					i = suffix;
+					while (i > memory && matches(i - 1, j))
+						--i;
+
+					if (i <= memory)
+						return haystack + j;
+
+					j += period;
+					memory = needle_size - period;
+				}
+			}
+			else
+			{
+				// the halves differ, every mismatch allows the maximal shift
+				period = (suffix > needle_size - suffix ? suffix : needle_size - suffix) + 1;
+
+				for (size_t j = 0; j <= last_start; )
+				{
+					auto i = suffix;
+					while (i < needle_size && matches(i, j))
+						++i;
+
+					if (i < needle_size)
+					{
+						j += i - suffix + 1;
+						continue;
+					}
+
+					i = suffix;
+					while (i > 0 && matches(i - 1, j))
+						--i;
+
+					if (i == 0)
+						return haystack + j;
+
+					j += period;
+				}
+			}
+
+			return nullptr;
+		}
+
+		// compare the first and last character of the needle against a chunk of candidate positions at once,
+		// only positions where both match are compared in full
+		template <bool IgnoreCase, typename CharType>
+		static const CharType* find_chunked(const CharType* haystack, size_t haystack_size, const CharType* needle, size_t needle_size)
+		{
+			if (!needle_size)
+				return haystack;
+
+			if (needle_size > haystack_size)
+				return nullptr;
+
+			if (needle_size > two_way_threshold)
+				return two_way_find<IgnoreCase>(haystack, haystack_size, needle, needle_size);
+
+			constexpr size_t characters_per_chunk = chunk_size / sizeof(CharType);
+			const auto first_character = fold_character<IgnoreCase>(needle[0]);
+			const auto first = splat(first_character);
+			const auto last = splat(fold_character<IgnoreCase>(needle[needle_size - 1]));
+			const auto positions = haystack_size - needle_size + 1;
+
+			size_t i = 0;
+			for (; i + characters_per_chunk <= positions; i += characters_per_chunk)
+			{
+				const auto first_match = equal<CharType>(first, fold_chunk<IgnoreCase, CharType>(load(haystack + i)));
+				const auto last_match = equal<CharType>(last, fold_chunk<IgnoreCase, CharType>(load(haystack + i + needle_size - 1)));
+
+				auto mask = byte_mask(and_chunk(first_match, last_match));
+				while (mask)
+				{
+					const auto bit = lowest_bit(mask);
+					const auto candidate = haystack + i + bit / sizeof(CharType);
+					if (equal_characters<IgnoreCase>(candidate, needle, needle_size))
+						return candidate;
+
+					mask = clear_character<CharType>(mask, bit);
+				}
+			}
+
+			for (; i < positions; ++i)
+			{
+				if (fold_character<IgnoreCase>(haystack[i]) == first_character && equal_characters<IgnoreCase>(haystack + i, needle, needle_size))
+					return haystack + i;
+			}
+
+			return nullptr;
+		}
+
+		size_t strlen_simd(const char* p_str)
+		{
+			return strlen_chunked(p_str);
+		}
+
+		size_t strlen_simd(const wchar_t* p_str)
+		{
+			return strlen_chunked(p_str);
+		}
+
+		int strcmp_simd(const char* str1, const char* str2)
+		{
+			return strcmp_chunked(str1, str2);
+		}
+
+		int strcmp_simd(const wchar_t* str1, const wchar_t* str2)
+		{
+			return strcmp_chunked(str1, str2);
+		}
+
+		const char* find_simd(const char* haystack, size_t haystack_size, const char* needle, size_t needle_size)
+		{
+			return find_chunked<false>(haystack, haystack_size, needle, needle_size);
+		}
+
+		const wchar_t* find_simd(const wchar_t* haystack, size_t haystack_size, const wchar_t* needle, size_t needle_size)
+		{
+			return find_chunked<false>(haystack, haystack_size, needle, needle_size);
+		}
+
+		const char* ifind_simd(const char* haystack, size_t haystack_size, const char* needle, size_t needle_size)
+		{
+			return find_chunked<true>(haystack, haystack_size, needle, needle_size);
+		}
+
+		const wchar_t* ifind_simd(const wchar_t* haystack, size_t haystack_size, const wchar_t* needle, size_t needle_size)
+		{
+			return find_chunked<true>(haystack, haystack_size, needle, needle_size);
+		}
+
+		bool iequal_simd(const char* str1, const char* str2, size_t size)
+		{
+			return iequal_chunked(str1, str2, size);
+		}
+
+		bool iequal_simd(const wchar_t* str1, const wchar_t* str2, size_t size)
+		{
+			return iequal_chunked(str1, str2, size);
+		}
+
+		void to_lower_simd(const char* str, size_t size, char* out)
+		{
+			flip_case_chunked(str, size, out, 'A');
+		}
+
+		void to_lower_simd(const wchar_t* str, size_t size, wchar_t* out)
+		{
+			flip_case_chunked(str, size, out, L'A');
+		}
+
+		void to_upper_simd(const char* str, size_t size, char* out)
+		{
+			flip_case_chunked(str, size, out, 'a');
+		}
+
+		void to_upper_simd(const wchar_t* str, size_t size, wchar_t* out)
+		{
+			flip_case_chunked(str, size, out, L'a');
+		}
+	}
+}
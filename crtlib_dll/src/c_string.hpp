@@ -1,12 +1,59 @@
 #pragma once
+#include <cstdint>
+#include <type_traits>
+
+#include "my_memory.h"
 
 namespace crt
 {
+	// ascii only, every other character is returned unchanged
+	template <typename CharType>
+	constexpr CharType to_lower_ascii(CharType c)
+	{
+		return c >= 'A' && c <= 'Z' ? static_cast<CharType>(c + ('a' - 'A')) : c;
+	}
+
+	template <typename CharType>
+	constexpr CharType to_upper_ascii(CharType c)
+	{
+		return c >= 'a' && c <= 'z' ? static_cast<CharType>(c - ('a' - 'A')) : c;
+	}
+
 	namespace detail
 	{
+		// sse2 (avx2 when compiled with it) implementations in c_string.cpp, the templates below
+		// dispatch to them at runtime for char and wchar_t and keep the scalar loops for constant evaluation
+		size_t strlen_simd(const char* p_str);
+		size_t strlen_simd(const wchar_t* p_str);
+		int strcmp_simd(const char* str1, const char* str2);
+		int strcmp_simd(const wchar_t* str1, const wchar_t* str2);
+		const char* find_simd(const char* haystack, size_t haystack_size, const char* needle, size_t needle_size);
+		const wchar_t* find_simd(const wchar_t* haystack, size_t haystack_size, const wchar_t* needle, size_t needle_size);
+
+		// ascii case insensitive variants, the characters are folded in registers so nothing is copied
+		const char* ifind_simd(const char* haystack, size_t haystack_size, const char* needle, size_t needle_size);
+		const wchar_t* ifind_simd(const wchar_t* haystack, size_t haystack_size, const wchar_t* needle, size_t needle_size);
+		bool iequal_simd(const char* str1, const char* str2, size_t size);
+		bool iequal_simd(const wchar_t* str1, const wchar_t* str2, size_t size);
+
+		// out may be str
+		void to_lower_simd(const char* str, size_t size, char* out);
+		void to_lower_simd(const wchar_t* str, size_t size, wchar_t* out);
+		void to_upper_simd(const char* str, size_t size, char* out);
+		void to_upper_simd(const wchar_t* str, size_t size, wchar_t* out);
+
+		template <typename CharType>
+		constexpr bool has_simd_string_v = std::is_same_v<CharType, char> || std::is_same_v<CharType, wchar_t>;
+
 		template <typename CharType>
 		constexpr size_t strlen_imp(const CharType* p_str)
 		{
+			if constexpr (has_simd_string_v<CharType>)
+			{
+				if (!std::is_constant_evaluated())
+					return strlen_simd(p_str);
+			}
+
 			size_t size = 0;
 			while (*p_str++)
 			{
@@ -35,6 +82,12 @@ namespace crt
 		template <typename CharType>
 		constexpr int strcmp_imp(const CharType* str1, const CharType* str2)
 		{
+			if constexpr (has_simd_string_v<CharType>)
+			{
+				if (!std::is_constant_evaluated())
+					return strcmp_simd(str1, str2);
+			}
+
 			for (size_t i = 0; ; i++)
 			{
 				if (str1[i] != str2[i])
@@ -44,30 +97,132 @@ namespace crt
 			}
 		}
 
+		// compares sized strings like strcmp_imp, characters past an embedded null included.
+		// a string that is a prefix of the other orders first
 		template <typename CharType>
-		constexpr const CharType* strstr_imp(const CharType* p_string, const CharType* p_substring)
+		constexpr int compare_imp(const CharType* str1, size_t size1, const CharType* str2, size_t size2)
 		{
-			/* check if both strings are empty */
-			if (p_string[0] == 0 && p_string[0] == p_substring[0])
-				return p_string;
+			const auto size = size1 < size2 ? size1 : size2;
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (str1[i] != str2[i])
+					return str1[i] > str2[i] ? 1 : -1;
+			}
 
-			const size_t size_of_substring = strlen_imp<CharType>(p_substring) * sizeof(CharType);
-			for (size_t i = 0; ; i++)
+			return size1 == size2 ? 0 : size1 > size2 ? 1 : -1;
+		}
+
+		// true if the first size characters of both strings are equal
+		template <typename CharType>
+		constexpr bool equal_imp(const CharType* str1, const CharType* str2, size_t size)
+		{
+			if (!std::is_constant_evaluated())
+				return !memcmp(str1, str2, size * sizeof(CharType));
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (str1[i] != str2[i])
+					return false;
+			}
+
+			return true;
+		}
+
+		// first occurrence of needle in haystack, both of known size. nullptr if there is none.
+		template <typename CharType>
+		constexpr const CharType* find_imp(const CharType* haystack, size_t haystack_size, const CharType* needle, size_t needle_size)
+		{
+			if constexpr (has_simd_string_v<CharType>)
+			{
+				if (!std::is_constant_evaluated())
+					return find_simd(haystack, haystack_size, needle, needle_size);
+			}
+
+			if (needle_size > haystack_size)
+				return nullptr;
+
+			for (size_t i = 0; i + needle_size <= haystack_size; ++i)
 			{
-				if (p_string[i] == 0)
-					break;
-
-				/* check for pattern match. notice that it is safe to use this
-				 * because the p_string is null terminated, and we will never
-				 * read bad memory, memcmp will return as soon as it sees the null terminator.
-				 */
-				if (!memcmp(p_string + i, p_substring, size_of_substring))
-					return p_string + i;
+				if (equal_imp(haystack + i, needle, needle_size))
+					return haystack + i;
 			}
 
 			return nullptr;
 		}
 
+		// true if the first size characters of both strings are equal ignoring ascii case
+		template <typename CharType>
+		constexpr bool iequal_imp(const CharType* str1, const CharType* str2, size_t size)
+		{
+			if constexpr (has_simd_string_v<CharType>)
+			{
+				if (!std::is_constant_evaluated())
+					return iequal_simd(str1, str2, size);
+			}
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				if (to_lower_ascii(str1[i]) != to_lower_ascii(str2[i]))
+					return false;
+			}
+
+			return true;
+		}
+
+		// find_imp ignoring ascii case
+		template <typename CharType>
+		constexpr const CharType* ifind_imp(const CharType* haystack, size_t haystack_size, const CharType* needle, size_t needle_size)
+		{
+			if constexpr (has_simd_string_v<CharType>)
+			{
+				if (!std::is_constant_evaluated())
+					return ifind_simd(haystack, haystack_size, needle, needle_size);
+			}
+
+			if (needle_size > haystack_size)
+				return nullptr;
+
+			for (size_t i = 0; i + needle_size <= haystack_size; ++i)
+			{
+				if (iequal_imp(haystack + i, needle, needle_size))
+					return haystack + i;
+			}
+
+			return nullptr;
+		}
+
+		template <typename CharType>
+		constexpr void to_lower_imp(const CharType* str, size_t size, CharType* out)
+		{
+			if constexpr (has_simd_string_v<CharType>)
+			{
+				if (!std::is_constant_evaluated())
+					return to_lower_simd(str, size, out);
+			}
+
+			for (size_t i = 0; i < size; ++i)
+				out[i] = to_lower_ascii(str[i]);
+		}
+
+		template <typename CharType>
+		constexpr void to_upper_imp(const CharType* str, size_t size, CharType* out)
+		{
+			if constexpr (has_simd_string_v<CharType>)
+			{
+				if (!std::is_constant_evaluated())
+					return to_upper_simd(str, size, out);
+			}
+
+			for (size_t i = 0; i < size; ++i)
+				out[i] = to_upper_ascii(str[i]);
+		}
+
+		template <typename CharType>
+		constexpr const CharType* strstr_imp(const CharType* p_string, const CharType* p_substring)
+		{
+			return find_imp(p_string, strlen_imp(p_string), p_substring, strlen_imp(p_substring));
+		}
+
 		template <typename CharType>
 		constexpr CharType* strstr_imp(CharType* p_string, const CharType* p_substring)
 		{
@@ -0,0 +1,404 @@
+#pragma once
+#include <cstdint>
+
+#include "my_memory.h"
+#include "my_vector.hpp"
+#include "hash_table.hpp"
+#include "maybe.hpp"
+#include "mutex.h"
+
+namespace crt
+{
+	struct cache_stats
+	{
+		size_t hits;
+		size_t misses;
+		size_t evictions;
+
+		float hit_ratio() const
+		{
+			const auto lookups = hits + misses;
+			return lookups ? (float)hits / (float)lookups : 0.f;
+		}
+	};
+
+	namespace detail
+	{
+		// every eviction leaves a tombstone in the index and a full cache never grows it, so without a purge the
+		// free slots run out and every miss probes the whole table. purging at a quarter of the keys keeps it amortized O(1)
+		template <typename K>
+		void purge_evicted(hash_map<K, uint32_t>& index)
+		{
+			if (index.tombstone_count() > index.size() / 4)
+				index.purge_tombstones();
+		}
+	}
+
+	// bounded cache that evicts the least recently used entry.
+	// entries live in a flat array and the recency list is made of indexes into it, so a hit only relinks
+	// two integers and an insert into a full cache reuses the evicted entry instead of allocating a node.
+	// pointers returned by get/put are valid until the next put.
+	template <typename K, typename V>
+	class lru_cache
+	{
+		constexpr static uint32_t npos = 0xFFFFFFFF;
+
+		struct entry
+		{
+			K key;
+			V value;
+			uint32_t prev;	// towards the most recently used entry
+			uint32_t next;	// towards the least recently used entry
+		};
+
+	public:
+		lru_cache() = default;
+
+		explicit lru_cache(size_t capacity) : capacity_(capacity)
+		{
+			entries_.reserve(capacity);
+			index_.reserve(capacity);
+		}
+
+		// returns nullptr if the key is not cached
+		V* get(const K& key)
+		{
+			const auto idx = index_.find_value(key);
+			if (!idx)
+			{
+				++stats_.misses;
+				return nullptr;
+			}
+
+			++stats_.hits;
+			touch(*idx);
+			return &entries_[*idx].value;
+		}
+
+		// insert or overwrite the value of the key, evicting the least recently used entry if the cache is full
+		V& put(K key, V value)
+		{
+			CRT_ASSERT(capacity_, "Cache without capacity!");
+
+			// removing the evicted key below only marks its own slot deleted, so the slot found here stays valid until the purge
+			auto result = index_.try_emplace(key, npos);
+			if (!result.second())
+			{
+				const auto idx = result.first()->get_value();
+				entries_[idx].value = crt::move(value);
+				touch(idx);
+				return entries_[idx].value;
+			}
+
+			uint32_t idx;
+			if (entries_.size() < capacity_)
+			{
+				idx = static_cast<uint32_t>(entries_.size());
+				result.first()->get_value() = idx;
+				entries_.push_back(entry{ crt::move(key), crt::move(value), npos, npos });
+			}
+			else
+			{
+				// reuse the least recently used entry
+				idx = tail_;
+				unlink(idx);
+				result.first()->get_value() = idx;
+				index_.remove(entries_[idx].key);
+				detail::purge_evicted(index_);
+				++stats_.evictions;
+
+				entries_[idx].key = crt::move(key);
+				entries_[idx].value = crt::move(value);
+			}
+
+			push_front(idx);
+			return entries_[idx].value;
+		}
+
+		// returns the cached value, or caches and returns compute(key) if the key is not cached
+		template <typename F>
+		V& get_or_compute(const K& key, F compute)
+		{
+			if (const auto value = get(key))
+				return *value;
+
+			return put(key, compute(key));
+		}
+
+		bool contains(const K& key) const
+		{
+			return index_.find_slot(key) != nullptr;
+		}
+
+		size_t size() const
+		{
+			return entries_.size();
+		}
+
+		size_t capacity() const
+		{
+			return capacity_;
+		}
+
+		const cache_stats& stats() const
+		{
+			return stats_;
+		}
+
+	private:
+		void unlink(uint32_t idx)
+		{
+			auto& e = entries_[idx];
+
+			if (e.prev != npos)
+				entries_[e.prev].next = e.next;
+			else
+				head_ = e.next;
+
+			if (e.next != npos)
+				entries_[e.next].prev = e.prev;
+			else
+				tail_ = e.prev;
+		}
+
+		void push_front(uint32_t idx)
+		{
+			auto& e = entries_[idx];
+			e.prev = npos;
+			e.next = head_;
+
+			if (head_ != npos)
+				entries_[head_].prev = idx;
+			else
+				tail_ = idx;
+
+			head_ = idx;
+		}
+
+		// mark the entry as most recently used
+		void touch(uint32_t idx)
+		{
+			if (idx == head_)
+				return;
+
+			unlink(idx);
+			push_front(idx);
+		}
+
+		vector<entry> entries_{};
+		hash_map<K, uint32_t> index_{};
+		uint32_t head_{ npos };
+		uint32_t tail_{ npos };
+		size_t capacity_{};
+		cache_stats stats_{};
+	};
+
+	// bounded cache with CLOCK (second chance) eviction. a hit only sets a reference bit, no links are touched,
+	// which makes hits cheaper than in lru_cache at the cost of a slightly less precise eviction order.
+	// pointers returned by get/put are valid until the next put.
+	template <typename K, typename V>
+	class clock_cache
+	{
+		struct entry
+		{
+			K key;
+			V value;
+			bool referenced;
+		};
+
+	public:
+		clock_cache() = default;
+
+		explicit clock_cache(size_t capacity) : capacity_(capacity)
+		{
+			entries_.reserve(capacity);
+			index_.reserve(capacity);
+		}
+
+		// returns nullptr if the key is not cached
+		V* get(const K& key)
+		{
+			const auto idx = index_.find_value(key);
+			if (!idx)
+			{
+				++stats_.misses;
+				return nullptr;
+			}
+
+			++stats_.hits;
+			entries_[*idx].referenced = true;
+			return &entries_[*idx].value;
+		}
+
+		// insert or overwrite the value of the key, evicting an entry that was not referenced since the last sweep if the cache is full
+		V& put(K key, V value)
+		{
+			CRT_ASSERT(capacity_, "Cache without capacity!");
+
+			if (const auto existing = index_.find_value(key))
+			{
+				auto& e = entries_[*existing];
+				e.value = crt::move(value);
+				e.referenced = true;
+				return e.value;
+			}
+
+			if (entries_.size() < capacity_)
+			{
+				index_.insert(key, static_cast<uint32_t>(entries_.size()));
+				entries_.push_back(entry{ crt::move(key), crt::move(value), false });
+				return entries_.back().value;
+			}
+
+			// advance the hand, giving referenced entries a second chance
+			while (entries_[hand_].referenced)
+			{
+				entries_[hand_].referenced = false;
+				hand_ = (hand_ + 1) % entries_.size();
+			}
+
+			const auto idx = hand_;
+			hand_ = (hand_ + 1) % entries_.size();
+
+			auto& victim = entries_[idx];
+			index_.remove(victim.key);
+			detail::purge_evicted(index_);
+			++stats_.evictions;
+
+			index_.insert(key, static_cast<uint32_t>(idx));
+			victim.key = crt::move(key);
+			victim.value = crt::move(value);
+			victim.referenced = false;
+			return victim.value;
+		}
+
+		// returns the cached value, or caches and returns compute(key) if the key is not cached
+		template <typename F>
+		V& get_or_compute(const K& key, F compute)
+		{
+			if (const auto value = get(key))
+				return *value;
+
+			return put(key, compute(key));
+		}
+
+		bool contains(const K& key) const
+		{
+			return index_.find_slot(key) != nullptr;
+		}
+
+		size_t size() const
+		{
+			return entries_.size();
+		}
+
+		size_t capacity() const
+		{
+			return capacity_;
+		}
+
+		const cache_stats& stats() const
+		{
+			return stats_;
+		}
+
+	private:
+		vector<entry> entries_{};
+		hash_map<K, uint32_t> index_{};
+		size_t hand_{};
+		size_t capacity_{};
+		cache_stats stats_{};
+	};
+
+	// thread safe cache made of ShardCount independently locked caches, the shard is picked by the hash of the key.
+	// values are returned by copy since a pointer into a shard is not safe to use after its lock is released.
+	// crt::sharded_cache<crt::lru_cache<crt::string, module_info>> cache(4096);
+	template <typename Cache, size_t ShardCount = 16>
+	class sharded_cache
+	{
+		template <typename T>
+		struct cache_types;
+
+		template <template <typename, typename> class C, typename Key, typename Value>
+		struct cache_types<C<Key, Value>>
+		{
+			using key_type = Key;
+			using value_type = Value;
+		};
+
+		using K = typename cache_types<Cache>::key_type;
+		using V = typename cache_types<Cache>::value_type;
+
+		struct shard
+		{
+			mutex lock;
+			Cache cache;
+		};
+
+	public:
+		// capacity is split evenly between the shards
+		explicit sharded_cache(size_t capacity)
+		{
+			const auto shard_capacity = (capacity + ShardCount - 1) / ShardCount;
+			for (auto& s : shards_)
+				s.cache = Cache(shard_capacity);
+		}
+
+		sharded_cache(const sharded_cache&) = delete;
+		sharded_cache& operator=(const sharded_cache&) = delete;
+
+		crt::maybe<V> get(const K& key)
+		{
+			auto& s = shard_of(key);
+			lock_guard guard{ s.lock };
+
+			if (const auto value = s.cache.get(key))
+				return crt::just(*value);
+
+			return crt::nothing<V>();
+		}
+
+		void put(K key, V value)
+		{
+			auto& s = shard_of(key);
+			lock_guard guard{ s.lock };
+
+			s.cache.put(crt::move(key), crt::move(value));
+		}
+
+		// compute is called while the shard is locked, so a key is never computed twice at the same time
+		template <typename F>
+		V get_or_compute(const K& key, F compute)
+		{
+			auto& s = shard_of(key);
+			lock_guard guard{ s.lock };
+
+			return s.cache.get_or_compute(key, compute);
+		}
+
+		// sum of the statistics of all shards
+		cache_stats stats()
+		{
+			cache_stats total{};
+			for (auto& s : shards_)
+			{
+				lock_guard guard{ s.lock };
+
+				const auto& shard_stats = s.cache.stats();
+				total.hits += shard_stats.hits;
+				total.misses += shard_stats.misses;
+				total.evictions += shard_stats.evictions;
+			}
+
+			return total;
+		}
+
+	private:
+		shard& shard_of(const K& key)
+		{
+			return shards_[crt::get_hash(key) % ShardCount];
+		}
+
+		shard shards_[ShardCount]{};
+	};
+}
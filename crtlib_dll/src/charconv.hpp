@@ -0,0 +1,366 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <intrin.h>
+
+#include "assert.h"
+
+namespace crt
+{
+	enum class chars_error : uint8_t
+	{
+		none,
+		buffer_too_small,	// the output did not fit, the buffer contents are unspecified
+		invalid_argument,	// no number at the start of the input
+		out_of_range,		// the number does not fit the type, the value is left unchanged
+	};
+
+	template <typename CharType>
+	struct to_chars_result
+	{
+		CharType* end;		// one past the last written character
+		chars_error error;
+	};
+
+	template <typename CharType>
+	struct from_chars_result
+	{
+		const CharType* end;	// the first character that is not part of the number, first when there is none
+		chars_error error;
+	};
+
+	// enough for any integer in any base: 64 binary digits and a sign
+	constexpr size_t max_integer_chars = 65;
+
+	namespace detail
+	{
+		// two digits per lookup, value * 2 is the offset of its pair
+		inline constexpr char decimal_digit_pairs[] =
+			"0001020304050607080910111213141516171819"
+			"2021222324252627282930313233343536373839"
+			"4041424344454647484950515253545556575859"
+			"6061626364656667686970717273747576777879"
+			"8081828384858687888990919293949596979899";
+
+		inline constexpr char hex_digit_pairs[] =
+			"000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+			"202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+			"404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+			"606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+			"808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+			"A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+			"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+			"E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
+
+		inline constexpr char digit_characters[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+		inline constexpr uint64_t powers_of_10[20] =
+		{
+			1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull, 10000000ull, 100000000ull, 1000000000ull,
+			10000000000ull, 100000000000ull, 1000000000000ull, 10000000000000ull, 100000000000000ull,
+			1000000000000000ull, 10000000000000000ull, 100000000000000000ull, 1000000000000000000ull, 10000000000000000000ull,
+		};
+
+		template <typename IntType>
+		constexpr bool is_chars_integer_v = std::is_integral_v<IntType> && !std::is_same_v<IntType, bool>;
+
+		// the magnitude is formatted in 32 bits when it fits, 64 bit division is slow on x86
+		template <typename IntType>
+		using chars_unsigned_t = std::conditional_t<(sizeof(IntType) > 4), uint64_t, uint32_t>;
+
+		// index of the highest set bit + 1, value != 0
+		inline uint32_t bit_length(uint64_t value)
+		{
+			unsigned long index;
+#ifdef _WIN64
+			_BitScanReverse64(&index, value);
+			return index + 1;
+#else
+			if (value >> 32)
+			{
+				_BitScanReverse(&index, static_cast<unsigned long>(value >> 32));
+				return index + 33;
+			}
+
+			_BitScanReverse(&index, static_cast<unsigned long>(value));
+			return index + 1;
+#endif
+		}
+
+		// floor(log10) estimated from the bit length, 1233 / 4096 ~ log10(2), then one compare corrects it.
+		// value | 1 keeps 0 at one digit without changing the count of any other value.
+		inline uint32_t decimal_digit_count(uint64_t value)
+		{
+			value |= 1;
+			const auto estimate = (bit_length(value) * 1233) >> 12;
+			return estimate + (value >= powers_of_10[estimate]);
+		}
+
+		// writes exactly digits characters ending at out + digits, two per division
+		template <typename CharType, typename UnsignedType>
+		void write_decimal(CharType* out, UnsignedType value, uint32_t digits)
+		{
+			auto p = out + digits;
+			while (value >= 100)
+			{
+				const auto pair = static_cast<size_t>(value % 100) * 2;
+				value /= 100;
+				*--p = static_cast<CharType>(decimal_digit_pairs[pair + 1]);
+				*--p = static_cast<CharType>(decimal_digit_pairs[pair]);
+			}
+
+			if (value >= 10)
+			{
+				const auto pair = static_cast<size_t>(value) * 2;
+				*--p = static_cast<CharType>(decimal_digit_pairs[pair + 1]);
+				*--p = static_cast<CharType>(decimal_digit_pairs[pair]);
+			}
+			else
+			{
+				*--p = static_cast<CharType>('0' + value);
+			}
+		}
+
+		template <typename CharType, typename UnsignedType>
+		void write_hex(CharType* out, UnsignedType value, uint32_t digits)
+		{
+			auto p = out + digits;
+			for (; digits >= 2; digits -= 2)
+			{
+				const auto pair = static_cast<size_t>(value & 0xFF) * 2;
+				value >>= 8;
+				*--p = static_cast<CharType>(hex_digit_pairs[pair + 1]);
+				*--p = static_cast<CharType>(hex_digit_pairs[pair]);
+			}
+
+			if (digits)
+				*--p = static_cast<CharType>(digit_characters[value & 0xF]);
+		}
+
+		template <typename CharType, typename UnsignedType>
+		to_chars_result<CharType> to_chars_unsigned(CharType* first, CharType* last, UnsignedType value, uint32_t base)
+		{
+			const auto available = static_cast<size_t>(last - first);
+
+			if (base == 10)
+			{
+				const auto digits = decimal_digit_count(value);
+				if (digits > available)
+					return { last, chars_error::buffer_too_small };
+
+				write_decimal(first, value, digits);
+				return { first + digits, chars_error::none };
+			}
+
+			// powers of two: the digit count follows from the bit length
+			if (!(base & (base - 1)))
+			{
+				const auto shift = bit_length(base) - 1;
+				const auto digits = value ? (bit_length(value) + shift - 1) / shift : 1;
+				if (digits > available)
+					return { last, chars_error::buffer_too_small };
+
+				if (base == 16)
+				{
+					write_hex(first, value, digits);
+				}
+				else
+				{
+					for (auto p = first + digits; p != first; value >>= shift)
+						*--p = static_cast<CharType>(digit_characters[value & (base - 1)]);
+				}
+
+				return { first + digits, chars_error::none };
+			}
+
+			uint32_t digits = 1;
+			for (auto rest = value / base; rest; rest /= base)
+				++digits;
+
+			if (digits > available)
+				return { last, chars_error::buffer_too_small };
+
+			for (auto p = first + digits; p != first; value /= base)
+				*--p = static_cast<CharType>(digit_characters[value % base]);
+
+			return { first + digits, chars_error::none };
+		}
+	}
+
+	namespace detail
+	{
+		// 36 for anything that is not a digit of any base, letters of either case are the digits past 9
+		template <typename CharType>
+		uint32_t digit_value(CharType c)
+		{
+			const auto code = static_cast<uint32_t>(c);
+			if (code - '0' < 10)
+				return code - '0';
+
+			const auto lower = code | 0x20;
+			if (lower - 'a' < 26)
+				return lower - 'a' + 10;
+
+			return 36;
+		}
+
+		inline uint64_t read_eight_chars(const char* p)
+		{
+			return *reinterpret_cast<const uint64_t*>(p);
+		}
+
+		// swar: 8 characters read as a little endian word, true if every byte is in '0'..'9'
+		inline bool is_eight_digits(uint64_t word)
+		{
+			return !(((word + 0x4646464646464646) | (word - 0x3030303030303030)) & 0x8080808080808080);
+		}
+
+		// the value of 8 digits, the first one in the lowest byte. the pairs, then the quads and then
+		// both halves are combined with one multiply each instead of 8 multiply adds.
+		inline uint32_t parse_eight_digits(uint64_t word)
+		{
+			constexpr uint64_t mask = 0x000000FF000000FF;
+			constexpr uint64_t mul1 = 100 + (1000000ull << 32);
+			constexpr uint64_t mul2 = 1 + (10000ull << 32);
+
+			word -= 0x3030303030303030;
+			word = (word * 10) + (word >> 8);
+			word = (((word & mask) * mul1) + (((word >> 16) & mask) * mul2)) >> 32;
+			return static_cast<uint32_t>(word);
+		}
+
+		// the magnitude of the digits at the start of [first, last), returns the end of the digits.
+		// every digit is consumed even when the value passes max, overflow is set then.
+		template <typename CharType>
+		const CharType* parse_unsigned(const CharType* first, const CharType* last, uint32_t base, uint64_t max, uint64_t& value, bool& overflow)
+		{
+			auto p = first;
+			uint64_t result = 0;
+			overflow = false;
+
+			if constexpr (sizeof(CharType) == 1)
+			{
+				// below 10^11, 8 more digits can not pass 2^64
+				if (base == 10)
+				{
+					while (last - p >= 8 && result < 100000000000ull)
+					{
+						const auto word = read_eight_chars(reinterpret_cast<const char*>(p));
+						if (!is_eight_digits(word))
+							break;
+
+						result = result * 100000000 + parse_eight_digits(word);
+						p += 8;
+					}
+				}
+			}
+
+			for (; p != last; ++p)
+			{
+				const auto digit = digit_value(*p);
+				if (digit >= base)
+					break;
+
+				if (result > (UINT64_MAX - digit) / base)
+					overflow = true;
+				else
+					result = result * base + digit;
+			}
+
+			overflow |= result > max;
+			value = result;
+			return p;
+		}
+	}
+
+	// parses an integer at the start of [first, last): an optional '-' for signed types and the digits of base,
+	// 2 to 36, letters of either case past 9. no whitespace, '+' or 0x prefix, like std::from_chars.
+	// value is only written on success, an out of range number still reports the end of its digits.
+	template <typename CharType, typename IntType>
+	std::enable_if_t<detail::is_chars_integer_v<IntType>, from_chars_result<CharType>>
+		from_chars(const CharType* first, const CharType* last, IntType& value, uint32_t base = 10)
+	{
+		CRT_ASSERT(base >= 2 && base <= 36, "from_chars base out of range!");
+
+		using unsigned_type = std::make_unsigned_t<IntType>;
+
+		auto p = first;
+		bool negative = false;
+		if constexpr (std::is_signed_v<IntType>)
+		{
+			if (p != last && *p == '-')
+			{
+				negative = true;
+				++p;
+			}
+		}
+
+		constexpr uint64_t max = static_cast<unsigned_type>(~unsigned_type(0)) >> std::is_signed_v<IntType>;
+
+		uint64_t magnitude;
+		bool overflow;
+		const auto end = detail::parse_unsigned(p, last, base, max + negative, magnitude, overflow);
+		if (end == p)
+			return { first, chars_error::invalid_argument };
+
+		if (overflow)
+			return { end, chars_error::out_of_range };
+
+		const auto bits = static_cast<unsigned_type>(magnitude);
+		value = static_cast<IntType>(negative ? unsigned_type(0) - bits : bits);
+		return { end, chars_error::none };
+	}
+
+	// formats value into [first, last) without a null terminator. base is 2 to 36, digits past 9 are upper case
+	// like int_to_hex. negative values are written as '-' and the magnitude in every base.
+	// at most max_integer_chars characters are written.
+	template <typename CharType, typename IntType>
+	std::enable_if_t<detail::is_chars_integer_v<IntType>, to_chars_result<CharType>>
+		to_chars(CharType* first, CharType* last, IntType value, uint32_t base = 10)
+	{
+		CRT_ASSERT(base >= 2 && base <= 36, "to_chars base out of range!");
+
+		using unsigned_type = detail::chars_unsigned_t<IntType>;
+
+		auto magnitude = static_cast<unsigned_type>(static_cast<std::make_unsigned_t<IntType>>(value));
+		if constexpr (std::is_signed_v<IntType>)
+		{
+			if (value < 0)
+			{
+				if (first == last)
+					return { last, chars_error::buffer_too_small };
+
+				*first++ = '-';
+				magnitude = static_cast<unsigned_type>(unsigned_type(0) - static_cast<unsigned_type>(value));
+			}
+		}
+
+		return detail::to_chars_unsigned(first, last, magnitude, base);
+	}
+
+	// longest shortest float output: sign, 17 digits, point and an exponent like e-308
+	constexpr size_t max_float_chars = 24;
+
+	constexpr uint32_t max_float_precision = 19;
+
+	// the shortest representation that parses back to the same value, in fixed or scientific notation
+	// whichever is shorter, fixed on a tie: 0.1, 100, 1e+20, 1.5e-07, inf, -nan. see charconv.cpp
+	to_chars_result<char> to_chars(char* first, char* last, double value);
+	to_chars_result<char> to_chars(char* first, char* last, float value);
+	to_chars_result<wchar_t> to_chars(wchar_t* first, wchar_t* last, double value);
+	to_chars_result<wchar_t> to_chars(wchar_t* first, wchar_t* last, float value);
+
+	// fixed notation with precision digits after the point, at most max_float_precision, like printf("%.*f").
+	// every digit is exact, up to 1 + 309 + 1 + max_float_precision characters.
+	to_chars_result<char> to_chars(char* first, char* last, double value, uint32_t precision);
+	to_chars_result<wchar_t> to_chars(wchar_t* first, wchar_t* last, double value, uint32_t precision);
+
+	// parses a decimal float at the start of [first, last) and rounds it to nearest even: an optional '-',
+	// digits with an optional point and an optional exponent like e-5, or inf, infinity and nan(chars)
+	// in any case. no whitespace, '+' or hex floats. overflow to infinity and underflow to zero are
+	// out_of_range and leave value unchanged. see charconv.cpp
+	from_chars_result<char> from_chars(const char* first, const char* last, double& value);
+	from_chars_result<char> from_chars(const char* first, const char* last, float& value);
+	from_chars_result<wchar_t> from_chars(const wchar_t* first, const wchar_t* last, double& value);
+	from_chars_result<wchar_t> from_chars(const wchar_t* first, const wchar_t* last, float& value);
+}
@@ -3,6 +3,8 @@
 #include <Shlobj.h>
 
 #include "format.hpp"
+#include "string_builder.hpp"
+#include "utf.hpp"
 #include "result.hpp"
 
 
@@ -96,7 +98,7 @@ IoResult windows::read_file(const crt::string& path)
 		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
 	if (h_file == INVALID_HANDLE_VALUE)
 	{
-		return IoResult::error(crt::format("Error opening file, code:{}", GetLastError()));
+		return IoResult::error(crt::concat("Error opening file, code:", crt::hex(GetLastError())));
 	}
 
 
@@ -106,7 +108,7 @@ IoResult windows::read_file(const crt::string& path)
 	if (!ReadFile(h_file, contents_.data(), static_cast<DWORD>(contents_.size()), nullptr, nullptr)) [[unlikely]]
 	{
 		CloseHandle(h_file);
-		return IoResult::error(crt::format("Error reading file, code:{}", GetLastError()));
+		return IoResult::error(crt::concat("Error reading file, code:", crt::hex(GetLastError())));
 	}
 
 	CloseHandle(h_file);
@@ -128,14 +130,14 @@ crt::result<size_t, crt::string> windows::write_file(const void* bytes, size_t s
 		nullptr, mode == overwrite ? CREATE_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
 	if (h_file == INVALID_HANDLE_VALUE)
 	{
-		return t_result::error(crt::format("Error CreateFileA, code:{}", GetLastError()));
+		return t_result::error(crt::concat("Error CreateFileA, code:", crt::hex(GetLastError())));
 	}
 
 	DWORD written = 0;
 	if (!WriteFile(h_file, bytes, size, &written, nullptr))
 	{
 		CloseHandle(h_file);
-		return t_result::error(crt::format("Error WriteFile, code:{}", GetLastError()));
+		return t_result::error(crt::concat("Error WriteFile, code:", crt::hex(GetLastError())));
 	}
 
 	CloseHandle(h_file);
@@ -168,31 +170,92 @@ crt::result<size_t, crt::string> windows::write_file(crt::vector<crt::string> li
 	return write_file(buffer.data(), buffer_iterator, path, mode);
 }
 
-crt::string windows::narrow_string(const wchar_t* p_wstr, size_t wstr_size)
+windows::mapped_file::~mapped_file()
 {
-	const auto characters_needed = WideCharToMultiByte(CP_UTF8, 0, p_wstr,
-		static_cast<int>(wstr_size), nullptr, 0, nullptr, nullptr);
+	if (view_)
+		UnmapViewOfFile(view_);
 
-	/* the resulting string will be null terminated if the p_wstr is null terminated */
-	crt::vector buffer((size_t)characters_needed, '\0');
+	if (h_mapping_)
+		CloseHandle(h_mapping_);
 
-	WideCharToMultiByte(CP_UTF8, 0, p_wstr,
-		static_cast<int>(wstr_size), buffer.data(), characters_needed, nullptr, nullptr);
+	if (h_file_ != INVALID_HANDLE_VALUE)
+		CloseHandle(h_file_);
+}
 
-	return crt::string{ buffer.data(), buffer.size() };
+windows::mapped_file::mapped_file(mapped_file&& other) noexcept
+{
+	swap(*this, other);
 }
 
-crt::wstring windows::widen_string(const char* p_str, size_t str_size)
+windows::mapped_file& windows::mapped_file::operator=(mapped_file&& other) noexcept
+{
+	mapped_file dead;
+	swap(*this, dead);
+	swap(*this, other);
+	return *this;
+}
+
+void windows::swap(mapped_file& lhs, mapped_file& rhs) noexcept
+{
+	crt::swap(lhs.h_file_, rhs.h_file_);
+	crt::swap(lhs.h_mapping_, rhs.h_mapping_);
+	crt::swap(lhs.view_, rhs.view_);
+	crt::swap(lhs.size_, rhs.size_);
+}
+
+const uint8_t* windows::mapped_file::data() const
 {
-	const auto characters_needed = MultiByteToWideChar(CP_UTF8, 0, p_str,
-		static_cast<int>(str_size), nullptr, 0);
+	return view_;
+}
+
+size_t windows::mapped_file::size() const
+{
+	return size_;
+}
+
+crt::result<windows::mapped_file, crt::string> windows::map_file(const crt::string& path)
+{
+	using t_result = crt::result<mapped_file, crt::string>;
+
+	mapped_file file;
+
+	file.h_file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ,
+		nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file.h_file_ == INVALID_HANDLE_VALUE)
+	{
+		return t_result::error(crt::concat("Error opening file, code:", crt::hex(GetLastError())));
+	}
+
+	LARGE_INTEGER file_size{};
+	if (!GetFileSizeEx(file.h_file_, &file_size) || !file_size.QuadPart)
+	{
+		return t_result::error(crt::string("Can't map an empty file!"));
+	}
+
+	file.h_mapping_ = CreateFileMappingA(file.h_file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!file.h_mapping_)
+	{
+		return t_result::error(crt::concat("Error CreateFileMappingA, code:", crt::hex(GetLastError())));
+	}
 
-	crt::vector buffer((size_t)characters_needed, L'\0');
+	file.view_ = static_cast<const uint8_t*>(MapViewOfFile(file.h_mapping_, FILE_MAP_READ, 0, 0, 0));
+	if (!file.view_)
+	{
+		return t_result::error(crt::concat("Error MapViewOfFile, code:", crt::hex(GetLastError())));
+	}
 
-	MultiByteToWideChar(CP_UTF8, 0, p_str,
-		static_cast<int>(str_size), buffer.data(), characters_needed);
+	file.size_ = static_cast<size_t>(file_size.QuadPart);
+	return t_result::ok(crt::move(file));
+}
 
-	return crt::wstring{ buffer.data(), buffer.size() };
+crt::string windows::narrow_string(const wchar_t* p_wstr, size_t wstr_size)
+{
+	return crt::wide_to_utf8(p_wstr, wstr_size);
+}
+
+crt::wstring windows::widen_string(const char* p_str, size_t str_size)
+{
+	return crt::utf8_to_wide(p_str, str_size);
 }
 
 void windows::print(const char* message)
@@ -9,8 +9,11 @@ typedef crt::vector<uint8_t> Bytes;
 typedef crt::result<Bytes, crt::string> IoResult;
 
 
-#define LOG_CONSOLE(...) windows::print(crt::format(__VA_ARGS__).c_str())
-#define ERR_CONSOLE(...) windows::print_error(crt::format(__VA_ARGS__).c_str())
+// formatted on the stack, only messages of console_format_capacity characters or more allocate
+constexpr size_t console_format_capacity = 512;
+
+#define LOG_CONSOLE(...) windows::print(crt::format_inline<console_format_capacity>(__VA_ARGS__).c_str())
+#define ERR_CONSOLE(...) windows::print_error(crt::format_inline<console_format_capacity>(__VA_ARGS__).c_str())
 
 namespace windows
 {
@@ -37,6 +40,35 @@ namespace windows
 	crt::result<size_t, crt::string> write_file(const void* bytes, size_t size, const crt::string& path, t_write_mode mode);
 	crt::result<size_t, crt::string> write_file(crt::vector<crt::string> lines, const crt::string& path, t_write_mode mode);
 
+	// read only view of a whole file mapped into memory, unmapped on destruction
+	class mapped_file
+	{
+	public:
+		mapped_file() = default;
+		~mapped_file();
+
+		mapped_file(const mapped_file&) = delete;
+		mapped_file& operator=(const mapped_file&) = delete;
+
+		mapped_file(mapped_file&& other) noexcept;
+		mapped_file& operator=(mapped_file&& other) noexcept;
+		friend void swap(mapped_file& lhs, mapped_file& rhs) noexcept;
+
+		const uint8_t* data() const;
+		size_t size() const;
+
+	private:
+		friend crt::result<mapped_file, crt::string> map_file(const crt::string& path);
+
+		HANDLE h_file_{ INVALID_HANDLE_VALUE };
+		HANDLE h_mapping_{};
+		const uint8_t* view_{};
+		size_t size_{};
+	};
+
+	// map the file read only. the view is page aligned, so it can be queried in place.
+	crt::result<mapped_file, crt::string> map_file(const crt::string& path);
+
 	// this is still needed when writing wide strings to log file
 	crt::string narrow_string(const wchar_t* p_wstr, size_t wstr_size);
 	crt::wstring widen_string(const char* p_str, size_t str_size);
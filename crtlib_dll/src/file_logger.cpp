@@ -2,6 +2,7 @@
 #include "my_memory.h"
 #include "crt_windows.h"
 #include "my_time.h"
+#include "utf.hpp"
 #define ENABLE_LOGGING
 
 
@@ -63,7 +64,7 @@ void crt::file_logger::print(const char* message)
 void crt::file_logger::print(const wchar_t* message)
 {
 
-	print(wstring(message));
+	print(wide_to_utf8(message, wcslen(message)));
 
 }
 
@@ -83,7 +84,7 @@ void crt::file_logger::print(void* pointer)
 
 void crt::file_logger::print(const wstring& message)
 {
-	print(windows::narrow_string(message.c_str(), message.size()));
+	print(wide_to_utf8(message));
 
 }
 
@@ -101,23 +102,44 @@ void crt::file_logger::print(const void* ptr, size_t size)
 	// append message to thread queue
 	buffer.reserve(buffer.size() + size);
 	buffer.insert(buffer.end(), static_cast<const char*>(ptr), size);
+	write_lines(buffer);
+}
+
+void crt::file_logger::write_lines(vector<char>& buffer)
+{
+	// each line goes out with its time prefix in one call, only lines longer than the stack buffer allocate
+	format_buffer<512> message;
+
+	char time[max_time_display_size];
+	size_t time_size = 0;
+
+	const auto begin = buffer.data();
+	const auto end = begin + buffer.size();
 
 	// parse the input
-	while(!buffer.empty())
+	auto line_begin = begin;
+	while (line_begin != end)
 	{
-		const auto message_end = find_first_of(buffer.begin(), buffer.end(), '\n');
-		if (message_end == buffer.end())
+		const auto message_end = find_first_of(line_begin, end, '\n');
+		if (message_end == end)
 		{
 			// no more data to process
 			break;
 		}
 
+		if (!time_size)
+			time_size = write_time_display(time);
+
 		// process message 
-		auto message = get_time_display();
-		message.insert(message.end(), &buffer.front(), message_end - buffer.begin() + 1);
+		message.clear();
+		message.append(time, time_size);
+		message.append(line_begin, message_end - line_begin + 1);
 		WriteFile(h_file_, message.c_str(), static_cast<DWORD>(message.size()), nullptr, nullptr);
 
-		// shrink the buffer
-		buffer = vector{ &*(message_end + 1), buffer.size() - (message_end - buffer.begin()) - 1 };
+		line_begin = message_end + 1;
 	}
+
+	// shrink the buffer, keeping its capacity for the next message
+	if (line_begin != begin)
+		buffer.erase(buffer.begin(), buffer.begin() + (line_begin - begin));
 }
@@ -5,6 +5,7 @@
 #include "mutex.h"
 #include "hash_table.hpp"
 #include "string_utils.hpp"
+#include "format.hpp"
 
 
 namespace crt
@@ -54,8 +55,24 @@ namespace crt
 		
 		void print(void* pointer); // cast pointer to uintptr_t then print the value
 
+		/* format straight into the thread buffer, print_format("{} of {}\n", done, total) */
+		template <typename T, typename... Types>
+		void print_format(format_string<T, Types...> fmt, const T& value, const Types&... values)
+		{
+			if (!active_)
+				return;
+
+			lock_guard guard{ mutex_ };
+
+			auto& buffer = threaded_buffer_[GetCurrentThreadId()];
+			format_to(buffer, fmt, value, values...);
+			write_lines(buffer);
+		}
+
 
 	private:
+		// writes every complete line of buffer to the file and removes them from it
+		void write_lines(vector<char>& buffer);
 
 
 		HANDLE h_file_{};
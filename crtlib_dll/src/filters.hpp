@@ -0,0 +1,564 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+#include <emmintrin.h>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+#include "assert.h"
+#include "hash.hpp"
+#include "my_memory.h"
+#include "my_string.hpp"
+#include "my_vector.hpp"
+#include "result.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		constexpr uint32_t bloom_magic = 0x4D4F4C42;	// "BLOM"
+		constexpr uint32_t cuckoo_magic = 0x4B435543;	// "CUCK"
+		constexpr uint32_t filter_version = 1;
+
+		struct filter_header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t element_size;	// bytes per fingerprint, 32 for bloom blocks
+			uint32_t reserved;
+			uint64_t bucket_count;	// blocks for bloom filters
+			uint64_t count;			// elements added
+		};
+
+		// 64 bit hash of any key that has a crt::get_hash overload. get_hash is only 32 bits wide on x86,
+		// mixing it again gives the filters independent upper and lower halves.
+		template <typename T>
+		uint64_t filter_hash(const T& key)
+		{
+			return hash_mix(static_cast<uint64_t>(crt::get_hash(key)));
+		}
+
+		// number of buckets below n, without a division: (x * n) >> 32
+		inline uint64_t fast_range(uint32_t x, uint64_t n)
+		{
+			return (static_cast<uint64_t>(x) * n) >> 32;
+		}
+	}
+
+	// blocked (split block) bloom filter. every key touches a single 32 byte block, setting one bit in each
+	// of its 8 words, so a lookup is one cache miss and one simd compare instead of k scattered bit tests.
+	// filters with the same block count can be merged, e.g. after building parts of a set on different threads.
+	//
+	// crt::bloom_filter filter(expected_count, 0.01f);
+	// filter.add(key);
+	// if (filter.may_contain(key)) ... // false positives possible, false negatives not
+	class bloom_filter
+	{
+		// not over aligned, crt::alloc only guarantees 16 bytes. blocks are read with unaligned loads.
+		struct block
+		{
+			uint32_t words[8];
+		};
+
+		// odd constants, one per word, that pick the bit position from the lower half of the hash
+		constexpr static uint32_t salts[8] =
+		{
+			0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+			0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u,
+		};
+
+	public:
+		using t_deserialize_result = crt::result<bloom_filter, crt::string>;
+
+		bloom_filter() = default;
+
+		// size the filter so that after expected_count insertions a lookup of a missing key
+		// returns true with probability false_positive_rate
+		bloom_filter(size_t expected_count, float false_positive_rate)
+		{
+			CRT_ASSERT(false_positive_rate > 0.f && false_positive_rate < 1.f, "Bloom filter false positive rate must be in (0, 1)!");
+
+			const auto keys_per_block = keys_per_block_for_rate(false_positive_rate);
+			const auto block_count = static_cast<size_t>(static_cast<double>(expected_count ? expected_count : 1) / keys_per_block) + 1;
+			blocks_ = vector<block>(block_count, block{});
+		}
+
+		template <typename T>
+		void add(const T& key)
+		{
+			add_hash(detail::filter_hash(key));
+		}
+
+		template <typename T>
+		bool may_contain(const T& key) const
+		{
+			return may_contain_hash(detail::filter_hash(key));
+		}
+
+		void add_hash(uint64_t hash)
+		{
+			CRT_ASSERT(!blocks_.empty(), "Bloom filter without capacity!");
+
+			auto& b = blocks_[block_of(hash)];
+			uint32_t mask[8];
+			make_mask(static_cast<uint32_t>(hash), mask);
+
+			for (int i = 0; i < 8; ++i)
+				b.words[i] |= mask[i];
+
+			++count_;
+		}
+
+		bool may_contain_hash(uint64_t hash) const
+		{
+			if (blocks_.empty())
+				return false;
+
+			const auto& b = blocks_[block_of(hash)];
+
+#if defined(__AVX2__)
+			const auto mask = make_mask(static_cast<uint32_t>(hash));
+			const auto words = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b.words));
+			return _mm256_testc_si256(words, mask) != 0;
+#else
+			alignas(16) uint32_t mask[8];
+			make_mask(static_cast<uint32_t>(hash), mask);
+
+			// a bit of the mask that is missing in the block shows up in andnot(block, mask)
+			const auto words = reinterpret_cast<const __m128i*>(b.words);
+			const auto masks = reinterpret_cast<const __m128i*>(mask);
+			const auto missing = _mm_or_si128(_mm_andnot_si128(_mm_loadu_si128(words), _mm_load_si128(masks)),
+				_mm_andnot_si128(_mm_loadu_si128(words + 1), _mm_load_si128(masks + 1)));
+
+			return _mm_movemask_epi8(_mm_cmpeq_epi32(missing, _mm_setzero_si128())) == 0xFFFF;
+#endif
+		}
+
+		// union of both filters. returns false if they were not created with the same size.
+		bool merge(const bloom_filter& other)
+		{
+			if (blocks_.size() != other.blocks_.size())
+				return false;
+
+			for (size_t i = 0; i < blocks_.size(); ++i)
+			{
+				for (int w = 0; w < 8; ++w)
+					blocks_[i].words[w] |= other.blocks_[i].words[w];
+			}
+
+			count_ += other.count_;
+			return true;
+		}
+
+		void clear()
+		{
+			for (auto& b : blocks_)
+				b = block{};
+
+			count_ = 0;
+		}
+
+		crt::vector<uint8_t> serialize() const
+		{
+			detail::filter_header header{};
+			header.magic = detail::bloom_magic;
+			header.version = detail::filter_version;
+			header.element_size = sizeof(block);
+			header.bucket_count = blocks_.size();
+			header.count = count_;
+
+			crt::vector<uint8_t> bytes(sizeof(header) + blocks_.size() * sizeof(block), 0);
+			memcpy(bytes.data(), &header, sizeof(header));
+			if (!blocks_.empty())
+				memcpy(bytes.data() + sizeof(header), blocks_.data(), blocks_.size() * sizeof(block));
+
+			return bytes;
+		}
+
+		static t_deserialize_result deserialize(const void* data, size_t size)
+		{
+			detail::filter_header header;
+			if (!data || size < sizeof(header))
+				return t_deserialize_result::error(crt::string("Bloom filter data is truncated!"));
+
+			memcpy(&header, data, sizeof(header));
+			if (header.magic != detail::bloom_magic || header.version != detail::filter_version || header.element_size != sizeof(block))
+				return t_deserialize_result::error(crt::string("Not a bloom filter or unsupported version!"));
+
+			if (header.bucket_count > (size - sizeof(header)) / sizeof(block))
+				return t_deserialize_result::error(crt::string("Bloom filter data is truncated!"));
+
+			bloom_filter filter;
+			filter.blocks_ = vector<block>(static_cast<size_t>(header.bucket_count), block{});
+			if (header.bucket_count)
+				memcpy(filter.blocks_.data(), static_cast<const uint8_t*>(data) + sizeof(header), filter.blocks_.size() * sizeof(block));
+
+			filter.count_ = static_cast<size_t>(header.count);
+			return t_deserialize_result::ok(crt::move(filter));
+		}
+
+		// number of add calls, duplicates included
+		size_t size() const
+		{
+			return count_;
+		}
+
+		size_t size_bytes() const
+		{
+			return blocks_.size() * sizeof(block);
+		}
+
+	private:
+		size_t block_of(uint64_t hash) const
+		{
+			return static_cast<size_t>(detail::fast_range(static_cast<uint32_t>(hash >> 32), blocks_.size()));
+		}
+
+		// the upper 5 bits of hash * salt select the bit of each word
+		static void make_mask(uint32_t hash, uint32_t(&mask)[8])
+		{
+			for (int i = 0; i < 8; ++i)
+				mask[i] = 1u << ((hash * salts[i]) >> 27);
+		}
+
+#if defined(__AVX2__)
+		static __m256i make_mask(uint32_t hash)
+		{
+			const auto salt = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(salts));
+			const auto bits = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int32_t>(hash)), salt), 27);
+			return _mm256_sllv_epi32(_mm256_set1_epi32(1), bits);
+		}
+#endif
+
+		// largest average number of keys per block that stays within the false positive rate.
+		// keys per block follow a poisson distribution, a missing key is a false positive if all 8 bits are set.
+		static double keys_per_block_for_rate(float false_positive_rate)
+		{
+			double low = 0.01, high = 64.0;
+			for (int iteration = 0; iteration < 40; ++iteration)
+			{
+				const auto middle = (low + high) / 2;
+				if (false_positive_rate_for(middle) > false_positive_rate)
+					high = middle;
+				else
+					low = middle;
+			}
+
+			return low;
+		}
+
+		static double false_positive_rate_for(double keys_per_block)
+		{
+			// the poisson weights are kept relative to p(0) = 1 and normalized at the end, which avoids exp()
+			double weight = 1.0, weight_sum = 0.0, rate_sum = 0.0;
+			double bit_clear = 1.0; // (31/32)^keys, probability that a given bit of a word is still clear
+
+			const auto max_keys = static_cast<int>(keys_per_block * 4) + 64;
+			for (int keys = 0; keys <= max_keys; ++keys)
+			{
+				const auto bit_set = 1.0 - bit_clear;
+				const auto bit_set_2 = bit_set * bit_set;
+				const auto bit_set_4 = bit_set_2 * bit_set_2;
+
+				weight_sum += weight;
+				rate_sum += weight * bit_set_4 * bit_set_4;
+
+				weight *= keys_per_block / (keys + 1);
+				bit_clear *= 31.0 / 32.0;
+			}
+
+			return rate_sum / weight_sum;
+		}
+
+		vector<block> blocks_{};
+		size_t count_{};
+	};
+
+	// cuckoo filter, a compact set of fingerprints that unlike a bloom filter supports removal.
+	// every key has two candidate buckets of 4 fingerprints, the second one is derived from the first and the
+	// fingerprint alone (i2 = i1 ^ hash(fingerprint)), so entries can be relocated without the original key.
+	// the false positive rate is about 8 / 2^bits of the fingerprint: ~3% for uint8_t, ~0.012% for uint16_t.
+	// remove only keys that were added, removing a key that was never added may remove another key's fingerprint.
+	template <typename Fingerprint = uint16_t>
+	class cuckoo_filter
+	{
+		static_assert(std::is_same_v<Fingerprint, uint8_t> || std::is_same_v<Fingerprint, uint16_t> || std::is_same_v<Fingerprint, uint32_t>,
+			"cuckoo_filter fingerprints must be uint8_t, uint16_t or uint32_t");
+
+		constexpr static size_t bucket_size = 4;
+		constexpr static size_t max_kicks = 500;
+		constexpr static Fingerprint empty_fingerprint = 0;
+
+		struct bucket
+		{
+			Fingerprint fingerprints[bucket_size];
+		};
+
+	public:
+		using t_deserialize_result = crt::result<cuckoo_filter, crt::string>;
+
+		cuckoo_filter() = default;
+
+		// buckets are sized for a load of about 95%, the highest load 4 way buckets reliably reach
+		explicit cuckoo_filter(size_t expected_count)
+		{
+			const auto needed_buckets = (expected_count * 100 / 95) / bucket_size + 1;
+
+			size_t bucket_count = 1;
+			while (bucket_count < needed_buckets)
+				bucket_count <<= 1;
+
+			buckets_ = vector<bucket>(bucket_count, bucket{});
+		}
+
+		// returns false if the filter is too full to place the key, the filter is unchanged in that case
+		template <typename T>
+		bool add(const T& key)
+		{
+			return add_hash(detail::filter_hash(key));
+		}
+
+		template <typename T>
+		bool may_contain(const T& key) const
+		{
+			return may_contain_hash(detail::filter_hash(key));
+		}
+
+		template <typename T>
+		bool remove(const T& key)
+		{
+			return remove_hash(detail::filter_hash(key));
+		}
+
+		bool add_hash(uint64_t hash)
+		{
+			CRT_ASSERT(!buckets_.empty(), "Cuckoo filter without capacity!");
+
+			const auto fingerprint = fingerprint_of(hash);
+			const auto index = index_of(hash);
+			return insert_fingerprint(fingerprint, index);
+		}
+
+		bool may_contain_hash(uint64_t hash) const
+		{
+			if (buckets_.empty())
+				return false;
+
+			const auto fingerprint = fingerprint_of(hash);
+			const auto index = index_of(hash);
+
+			return bucket_contains(buckets_[index], fingerprint) || bucket_contains(buckets_[alternate_index(index, fingerprint)], fingerprint);
+		}
+
+		bool remove_hash(uint64_t hash)
+		{
+			if (buckets_.empty())
+				return false;
+
+			const auto fingerprint = fingerprint_of(hash);
+			const auto index = index_of(hash);
+
+			if (remove_from_bucket(buckets_[index], fingerprint) || remove_from_bucket(buckets_[alternate_index(index, fingerprint)], fingerprint))
+			{
+				--count_;
+				return true;
+			}
+
+			return false;
+		}
+
+		// add every fingerprint of other. returns false if the sizes differ or this filter ran full,
+		// in which case part of other may already have been added.
+		bool merge(const cuckoo_filter& other)
+		{
+			if (buckets_.size() != other.buckets_.size())
+				return false;
+
+			for (size_t index = 0; index < other.buckets_.size(); ++index)
+			{
+				for (const auto fingerprint : other.buckets_[index].fingerprints)
+				{
+					if (fingerprint != empty_fingerprint && !insert_fingerprint(fingerprint, index))
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		void clear()
+		{
+			for (auto& b : buckets_)
+				b = bucket{};
+
+			count_ = 0;
+		}
+
+		crt::vector<uint8_t> serialize() const
+		{
+			detail::filter_header header{};
+			header.magic = detail::cuckoo_magic;
+			header.version = detail::filter_version;
+			header.element_size = sizeof(Fingerprint);
+			header.bucket_count = buckets_.size();
+			header.count = count_;
+
+			crt::vector<uint8_t> bytes(sizeof(header) + buckets_.size() * sizeof(bucket), 0);
+			memcpy(bytes.data(), &header, sizeof(header));
+			if (!buckets_.empty())
+				memcpy(bytes.data() + sizeof(header), buckets_.data(), buckets_.size() * sizeof(bucket));
+
+			return bytes;
+		}
+
+		static t_deserialize_result deserialize(const void* data, size_t size)
+		{
+			detail::filter_header header;
+			if (!data || size < sizeof(header))
+				return t_deserialize_result::error(crt::string("Cuckoo filter data is truncated!"));
+
+			memcpy(&header, data, sizeof(header));
+			if (header.magic != detail::cuckoo_magic || header.version != detail::filter_version || header.element_size != sizeof(Fingerprint))
+				return t_deserialize_result::error(crt::string("Not a cuckoo filter or unsupported version!"));
+
+			if (header.bucket_count & (header.bucket_count - 1) || header.bucket_count > (size - sizeof(header)) / sizeof(bucket))
+				return t_deserialize_result::error(crt::string("Cuckoo filter data is corrupt!"));
+
+			cuckoo_filter filter;
+			filter.buckets_ = vector<bucket>(static_cast<size_t>(header.bucket_count), bucket{});
+			if (header.bucket_count)
+				memcpy(filter.buckets_.data(), static_cast<const uint8_t*>(data) + sizeof(header), filter.buckets_.size() * sizeof(bucket));
+
+			filter.count_ = static_cast<size_t>(header.count);
+			return t_deserialize_result::ok(crt::move(filter));
+		}
+
+		// number of fingerprints stored
+		size_t size() const
+		{
+			return count_;
+		}
+
+		float load_factor() const
+		{
+			return buckets_.empty() ? 1.f : (float)count_ / (float)(buckets_.size() * bucket_size);
+		}
+
+		size_t size_bytes() const
+		{
+			return buckets_.size() * sizeof(bucket);
+		}
+
+	private:
+		// 0 marks an empty entry, fingerprints are never 0
+		static Fingerprint fingerprint_of(uint64_t hash)
+		{
+			const auto fingerprint = static_cast<Fingerprint>(hash);
+			return fingerprint != empty_fingerprint ? fingerprint : 1;
+		}
+
+		size_t index_of(uint64_t hash) const
+		{
+			return static_cast<size_t>(hash >> 32) & (buckets_.size() - 1);
+		}
+
+		// an involution: the alternate of the alternate index is the original index
+		size_t alternate_index(size_t index, Fingerprint fingerprint) const
+		{
+			return (index ^ static_cast<size_t>(hash_mix(fingerprint))) & (buckets_.size() - 1);
+		}
+
+		static bool bucket_contains(const bucket& b, Fingerprint fingerprint)
+		{
+			bool found = false;
+			for (const auto f : b.fingerprints)
+				found |= f == fingerprint;
+
+			return found;
+		}
+
+		static bool insert_into_bucket(bucket& b, Fingerprint fingerprint)
+		{
+			for (auto& f : b.fingerprints)
+			{
+				if (f == empty_fingerprint)
+				{
+					f = fingerprint;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		static bool remove_from_bucket(bucket& b, Fingerprint fingerprint)
+		{
+			for (auto& f : b.fingerprints)
+			{
+				if (f == fingerprint)
+				{
+					f = empty_fingerprint;
+					return true;
+				}
+			}
+
+			return false;
+		}
+
+		bool insert_fingerprint(Fingerprint fingerprint, size_t index)
+		{
+			const auto alternate = alternate_index(index, fingerprint);
+			if (insert_into_bucket(buckets_[index], fingerprint) || insert_into_bucket(buckets_[alternate], fingerprint))
+			{
+				++count_;
+				return true;
+			}
+
+			// both buckets are full, evict random fingerprints to their alternate buckets.
+			// the evictions are recorded so a failed insertion can be rolled back.
+			struct kick
+			{
+				size_t index;
+				uint32_t slot;
+			};
+
+			kick kicks[max_kicks];
+			auto current = (next_random() & 1) ? index : alternate;
+			auto carried = fingerprint;
+
+			for (size_t k = 0; k < max_kicks; ++k)
+			{
+				const auto slot = static_cast<uint32_t>(next_random() % bucket_size);
+				kicks[k] = { current, slot };
+				crt::swap(carried, buckets_[current].fingerprints[slot]);
+
+				current = alternate_index(current, carried);
+				if (insert_into_bucket(buckets_[current], carried))
+				{
+					++count_;
+					return true;
+				}
+			}
+
+			// undo the evictions in reverse order, carried ends up being the new fingerprint again
+			for (size_t k = max_kicks; k > 0; --k)
+				crt::swap(carried, buckets_[kicks[k - 1].index].fingerprints[kicks[k - 1].slot]);
+
+			return false;
+		}
+
+		// xorshift, only used to pick eviction victims
+		uint32_t next_random()
+		{
+			random_state_ ^= random_state_ << 13;
+			random_state_ ^= random_state_ >> 17;
+			random_state_ ^= random_state_ << 5;
+			return random_state_;
+		}
+
+		vector<bucket> buckets_{};
+		size_t count_{};
+		uint32_t random_state_{ 0x9E3779B9u };
+	};
+}
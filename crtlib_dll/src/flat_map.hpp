@@ -0,0 +1,431 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+#include "my_memory.h"
+#include "my_vector.hpp"
+#include "algorithm_sort.hpp"
+#include "iterator.hpp"
+#include "pair.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		// index of the first element that is not less than key. the loop has no data dependent branches,
+		// the comparison result only selects the next base, which the compiler turns into a conditional move.
+		template <typename T>
+		size_t branchless_lower_bound(const T* first, size_t size, const T& key)
+		{
+			if (!size)
+				return 0;
+
+			const T* base = first;
+			while (size > 1)
+			{
+				const auto half = size / 2;
+				base = (base[half] < key) ? base + half : base;
+				size -= half;
+			}
+
+			return (base - first) + (*base < key);
+		}
+
+		// index of the first element that is greater than key
+		template <typename T>
+		size_t branchless_upper_bound(const T* first, size_t size, const T& key)
+		{
+			if (!size)
+				return 0;
+
+			const T* base = first;
+			while (size > 1)
+			{
+				const auto half = size / 2;
+				base = !(key < base[half]) ? base + half : base;
+				size -= half;
+			}
+
+			return (base - first) + !(key < *base);
+		}
+
+		// sort elements by key, keeping the last of the equal keys. the sort is done on an index permutation
+		// so the (possibly large) elements are moved once, and ties are broken by the insertion order.
+		template <typename T, typename KeyOf>
+		vector<T> sort_unique_last(vector<T>& elements, KeyOf key_of)
+		{
+			const auto count = elements.size();
+
+			vector<uint32_t> order(count);
+			for (uint32_t i = 0; i < count; ++i)
+				order.push_back(i);
+
+			// crt::sort expects a predicate that returns true if lhs should be placed after rhs
+			crt::sort(order.begin(), order.end(), [&elements, &key_of](uint32_t lhs, uint32_t rhs)
+			{
+				const auto& lhs_key = key_of(elements[lhs]);
+				const auto& rhs_key = key_of(elements[rhs]);
+
+				if (rhs_key < lhs_key)
+					return true;
+
+				return !(lhs_key < rhs_key) && lhs > rhs;
+			});
+
+			vector<T> sorted(count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				// skip an element if the next one has the same key, the later insertion wins
+				if (i + 1 < count && !(key_of(elements[order[i]]) < key_of(elements[order[i + 1]])))
+					continue;
+
+				sorted.push_back(crt::move(elements[order[i]]));
+			}
+
+			return sorted;
+		}
+	}
+
+	// ordered map stored as two sorted vectors, one for the keys and one for the values.
+	// searching only touches the densely packed keys, which for small and read mostly maps beats the
+	// slot overhead and probing of hash_map. insertions are O(n), so build large maps in bulk:
+	// either through the constructors or insert_bulk, which append everything and sort once.
+	// keys need operator< and are compared for equality as !(a < b) && !(b < a).
+	template <typename K, typename V>
+	class flat_map
+	{
+		template <typename ValuePointer>
+		struct iterator_base
+		{
+			constexpr static auto tag()
+			{
+				return random_iterator_tag{};
+			}
+
+			iterator_base(const K* key, ValuePointer value) : key_(key), value_(value) {}
+
+			crt::pair<const K*, ValuePointer> operator*() const
+			{
+				return crt::make_pair(key_, value_);
+			}
+
+			const K& key() const { return *key_; }
+			auto& value() const { return *value_; }
+
+			iterator_base& operator--() { --key_; --value_; return *this; }
+			iterator_base operator--(int) { iterator_base tmp = *this; --(*this); return tmp; }
+
+			iterator_base& operator++() { ++key_; ++value_; return *this; }
+			iterator_base operator++(int) { iterator_base tmp = *this; ++(*this); return tmp; }
+
+			friend iterator_base operator- (const iterator_base& a, size_t distance) { return iterator_base(a.key_ - distance, a.value_ - distance); }
+			friend iterator_base operator+ (const iterator_base& a, size_t distance) { return iterator_base(a.key_ + distance, a.value_ + distance); }
+			friend size_t operator- (const iterator_base& a, const iterator_base& b) { return a.key_ - b.key_; }
+			friend bool operator== (const iterator_base& a, const iterator_base& b) { return a.key_ == b.key_; }
+			friend bool operator!= (const iterator_base& a, const iterator_base& b) { return a.key_ != b.key_; }
+
+		private:
+			friend class flat_map;
+
+			const K* key_;
+			ValuePointer value_;
+		};
+
+	public:
+		using iterator = iterator_base<V*>;
+		using const_iterator = iterator_base<const V*>;
+
+		flat_map() = default;
+
+		flat_map(std::initializer_list<crt::pair<K, V>> args)
+		{
+			vector<crt::pair<K, V>> entries(args.size());
+			for (const auto& elem : args)
+				entries.push_back(elem);
+
+			insert_bulk(crt::move(entries));
+		}
+
+		// bulk construction, sorts once. for duplicate keys the last entry wins.
+		explicit flat_map(vector<crt::pair<K, V>> entries)
+		{
+			insert_bulk(crt::move(entries));
+		}
+
+		// insert all entries, overwriting existing keys. the entries are appended and the map is sorted once,
+		// O((n + m) log(n + m)) instead of m sorted insertions.
+		void insert_bulk(vector<crt::pair<K, V>> entries)
+		{
+			vector<crt::pair<K, V>> all(size() + entries.size());
+
+			for (size_t i = 0; i < size(); ++i)
+				all.push_back(crt::make_pair(crt::move(keys_[i]), crt::move(values_[i])));
+
+			for (auto& entry : entries)
+				all.push_back(crt::move(entry));
+
+			auto sorted = detail::sort_unique_last(all, [](const crt::pair<K, V>& entry) -> const K& { return entry.first(); });
+
+			vector<K> keys(sorted.size());
+			vector<V> values(sorted.size());
+			for (auto& entry : sorted)
+			{
+				keys.push_back(crt::move(entry.first()));
+				values.push_back(crt::move(entry.second()));
+			}
+
+			swap(keys_, keys);
+			swap(values_, values);
+		}
+
+		// insert key/value, overwriting the value if the key already exists. O(n)
+		V& insert(K key, V value)
+		{
+			const auto idx = lower_bound_index(key);
+			if (idx < size() && !(key < keys_[idx]))
+			{
+				values_[idx] = crt::move(value);
+				return values_[idx];
+			}
+
+			keys_.insert(keys_.begin() + idx, crt::move(key));
+			values_.insert(values_.begin() + idx, crt::move(value));
+			return values_[idx];
+		}
+
+		// returns the value by ref if key exists, otherwise inserts it and returns the value by ref.
+		V& find_or_insert(const K& key)
+		{
+			const auto idx = lower_bound_index(key);
+			if (idx < size() && !(key < keys_[idx]))
+				return values_[idx];
+
+			keys_.insert(keys_.begin() + idx, key);
+			values_.insert(values_.begin() + idx, V{});
+			return values_[idx];
+		}
+
+		V& operator[](const K& key)
+		{
+			return find_or_insert(key);
+		}
+
+		// find value by key, returns nullptr if the key does not exist
+		V* find_value(const K& key)
+		{
+			const auto idx = find_index(key);
+			return idx < size() ? &values_[idx] : nullptr;
+		}
+
+		const V* find_value(const K& key) const
+		{
+			const auto idx = find_index(key);
+			return idx < size() ? &values_[idx] : nullptr;
+		}
+
+		bool contains(const K& key) const
+		{
+			return find_index(key) < size();
+		}
+
+		// remove key/value pair if it exists
+		void remove(const K& key)
+		{
+			const auto idx = find_index(key);
+			if (idx < size())
+			{
+				keys_.erase_idx(idx);
+				values_.erase_idx(idx);
+			}
+		}
+
+		// first element whose key is not less than key
+		iterator lower_bound(const K& key)
+		{
+			return at(lower_bound_index(key));
+		}
+
+		const_iterator lower_bound(const K& key) const
+		{
+			return at(lower_bound_index(key));
+		}
+
+		// first element whose key is greater than key
+		iterator upper_bound(const K& key)
+		{
+			return at(detail::branchless_upper_bound(keys_.data(), keys_.size(), key));
+		}
+
+		const_iterator upper_bound(const K& key) const
+		{
+			return at(detail::branchless_upper_bound(keys_.data(), keys_.size(), key));
+		}
+
+		// in increasing key order
+		iterator begin() { return at(0); }
+		iterator end() { return at(size()); }
+		const_iterator begin() const { return at(0); }
+		const_iterator end() const { return at(size()); }
+
+		void reserve(size_t capacity)
+		{
+			keys_.reserve(capacity);
+			values_.reserve(capacity);
+		}
+
+		size_t size() const
+		{
+			return keys_.size();
+		}
+
+		bool empty() const
+		{
+			return keys_.empty();
+		}
+
+		// sorted keys, values_[i] belongs to keys_[i]
+		const vector<K>& keys() const
+		{
+			return keys_;
+		}
+
+		const vector<V>& values() const
+		{
+			return values_;
+		}
+
+	private:
+		size_t lower_bound_index(const K& key) const
+		{
+			return detail::branchless_lower_bound(keys_.data(), keys_.size(), key);
+		}
+
+		// returns size() if the key does not exist
+		size_t find_index(const K& key) const
+		{
+			const auto idx = lower_bound_index(key);
+			return idx < size() && !(key < keys_[idx]) ? idx : size();
+		}
+
+		iterator at(size_t idx)
+		{
+			return iterator(keys_.data() + idx, values_.data() + idx);
+		}
+
+		const_iterator at(size_t idx) const
+		{
+			return const_iterator(keys_.data() + idx, values_.data() + idx);
+		}
+
+		vector<K> keys_{};
+		vector<V> values_{};
+	};
+
+	// ordered set stored as a sorted vector, see flat_map.
+	template <typename T>
+	class flat_set
+	{
+	public:
+		using value_type = T;
+		using const_iterator = typename vector<T>::const_iterator;
+
+		flat_set() = default;
+
+		flat_set(std::initializer_list<T> args)
+		{
+			vector<T> elements(args.size());
+			for (const auto& elem : args)
+				elements.push_back(elem);
+
+			add_bulk(crt::move(elements));
+		}
+
+		// bulk construction, sorts once
+		explicit flat_set(vector<T> elements)
+		{
+			add_bulk(crt::move(elements));
+		}
+
+		// add all elements, sorting once
+		void add_bulk(vector<T> elements)
+		{
+			for (auto& elem : elements_)
+				elements.push_back(crt::move(elem));
+
+			elements_ = detail::sort_unique_last(elements, [](const T& elem) -> const T& { return elem; });
+		}
+
+		// O(n)
+		void add(T value)
+		{
+			const auto idx = detail::branchless_lower_bound(elements_.data(), elements_.size(), value);
+			if (idx < size() && !(value < elements_[idx]))
+				return;
+
+			elements_.insert(elements_.begin() + idx, crt::move(value));
+		}
+
+		void push_back(T value)
+		{
+			add(crt::move(value));
+		}
+
+		void remove(const T& value)
+		{
+			const auto idx = find_index(value);
+			if (idx < size())
+				elements_.erase_idx(idx);
+		}
+
+		bool contains(const T& value) const
+		{
+			return find_index(value) < size();
+		}
+
+		// first element that is not less than value
+		const_iterator lower_bound(const T& value) const
+		{
+			return begin() + detail::branchless_lower_bound(elements_.data(), elements_.size(), value);
+		}
+
+		// first element that is greater than value
+		const_iterator upper_bound(const T& value) const
+		{
+			return begin() + detail::branchless_upper_bound(elements_.data(), elements_.size(), value);
+		}
+
+		// in increasing order
+		const_iterator begin() const { return elements_.begin(); }
+		const_iterator end() const { return elements_.end(); }
+
+		void reserve(size_t capacity)
+		{
+			elements_.reserve(capacity);
+		}
+
+		size_t size() const
+		{
+			return elements_.size();
+		}
+
+		bool empty() const
+		{
+			return elements_.empty();
+		}
+
+		const vector<T>& elements() const
+		{
+			return elements_;
+		}
+
+	private:
+		// returns size() if the value does not exist
+		size_t find_index(const T& value) const
+		{
+			const auto idx = detail::branchless_lower_bound(elements_.data(), elements_.size(), value);
+			return idx < size() && !(value < elements_[idx]) ? idx : size();
+		}
+
+		vector<T> elements_{};
+	};
+}
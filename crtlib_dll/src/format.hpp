@@ -1,56 +1,758 @@
 #pragma once
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+#include "my_memory.h"
 #include "my_string.hpp"
-#include "to_string.h"
+#include "my_vector.hpp"
+#include "string_builder.hpp"
 
 namespace crt
 {
 	namespace detail
 	{
-		inline crt::string do_format_replace(char* start, char* end)
+		// not constexpr on purpose, reaching a call to this while parsing a format string at compile time fails the compilation.
+		void format_string_error(const char* reason);
+
+		// widths are padding, anything larger is a typo
+		constexpr uint32_t max_format_width = 0xFFFF;
+
+		enum class format_align : uint8_t
+		{
+			none,
+			left,
+			right,
+			center,
+		};
+
+		// [[fill]align][0][width][.precision][type] of one replacement field
+		template <typename CharType>
+		struct format_spec
+		{
+			CharType fill{ ' ' };
+			format_align align{ format_align::none };
+			bool zero_pad{};
+			uint32_t width{};
+			int32_t precision{ -1 };
+			char type{};
+		};
+
+		// literal text of the format string, escaped if it contains doubled braces
+		struct format_segment
+		{
+			uint32_t offset{};
+			uint32_t size{};
+			bool escaped{};
+		};
+
+		// a replacement field and the literal text in front of it
+		template <typename CharType>
+		struct format_field
+		{
+			format_segment literal{};
+			format_spec<CharType> spec{};
+		};
+
+		enum class format_kind : uint8_t
+		{
+			none,
+			integer,
+			character,
+			boolean,
+			floating,
+			text,
+			pointer,
+		};
+
+		// arguments are decayed, a string literal argument is a CharType pointer
+		template <typename CharType, typename T>
+		constexpr format_kind format_kind_of()
 		{
-			return crt::string{ start };
+			if constexpr (std::is_same_v<T, CharType>)
+				return format_kind::character;
+			else if constexpr (std::is_same_v<T, bool>)
+				return format_kind::boolean;
+			else if constexpr (is_printable_integer_v<T>)
+				return format_kind::integer;
+			else if constexpr (std::is_floating_point_v<T>)
+				return format_kind::floating;
+			else if constexpr (std::is_same_v<T, const CharType*> || std::is_same_v<T, CharType*> || has_c_str<CharType, T>::value)
+				return format_kind::text;
+			else if constexpr (std::is_pointer_v<T>)
+				return format_kind::pointer;
+			else
+				return format_kind::none;
 		}
 
-		template <typename T, typename... Types>
-		crt::string do_format_replace(char* start, char* end, T token, Types... tokens)
+		// integers take d, x and X, floats f and a precision, text s and a precision that cuts it, characters c.
+		// '0' pads numbers with zeros after the sign. numbers are right aligned by default, everything else left.
+		template <typename CharType, typename T>
+		constexpr void check_format_spec(format_spec<CharType>& spec)
 		{
-			const auto token_start = crt::find_first_of(start, end, '{');
-			CRT_ASSERT(token_start != end, "invalid format");
+			constexpr auto kind = format_kind_of<CharType, std::decay_t<T>>();
+			static_assert(kind != format_kind::none, "format argument type can not be formatted");
 
-			const auto token_end = crt::find_first_of(token_start + 1, end, '}');
-			CRT_ASSERT(token_end != end, "invalid format");
+			const bool number = kind == format_kind::integer || kind == format_kind::floating;
+			if (spec.zero_pad && !number)
+				format_string_error("'0' padding is only for numbers");
 
-			crt::string final_string{};
-			const auto token_string = crt::to_string(token);
+			if (spec.precision >= 0 && kind != format_kind::floating && kind != format_kind::text)
+				format_string_error("precision is only for floats and strings");
 
-			const auto left_substr_size = token_start - start;
-			if (left_substr_size > 0)
+			if (kind == format_kind::floating && spec.precision > static_cast<int32_t>(max_float_decimals))
+				format_string_error("float precision is limited to max_float_decimals");
+
+			if (spec.type)
 			{
-				crt::string left_substr{ start, (size_t)left_substr_size };
-				left_substr += token_string;
-				final_string = move(left_substr);
+				bool valid;
+				switch (kind)
+				{
+				case format_kind::integer:
+					valid = spec.type == 'd' || spec.type == 'x' || spec.type == 'X';
+					break;
+				case format_kind::floating:
+					valid = spec.type == 'f';
+					break;
+				case format_kind::text:
+					valid = spec.type == 's';
+					break;
+				case format_kind::character:
+					valid = spec.type == 'c';
+					break;
+				default:
+					valid = false;
+					break;
+				}
+
+				if (!valid)
+					format_string_error("format type does not match the argument");
 			}
+
+			if (spec.align == format_align::none)
+				spec.align = number || kind == format_kind::pointer ? format_align::right : format_align::left;
 			else
+				spec.zero_pad = false;
+		}
+
+		template <typename CharType>
+		constexpr bool is_format_digit(CharType c)
+		{
+			return c >= '0' && c <= '9';
+		}
+
+		template <typename CharType>
+		constexpr format_align to_format_align(CharType c)
+		{
+			return c == '<' ? format_align::left : c == '>' ? format_align::right : c == '^' ? format_align::center : format_align::none;
+		}
+	}
+
+	// a format string checked and split at compile time: every replacement field has its argument, every spec
+	// suits the type of its argument, and the literal text between the fields is kept as offsets into the string.
+	// fields are {} or {:spec}, {{ and }} are braces.
+	template <typename CharType, typename... Args>
+	class basic_format_string
+	{
+	public:
+		template <size_t N>
+		consteval basic_format_string(const CharType(&str)[N]) : str_(str)
+		{
+			parse(N - 1);
+			check_fields(std::index_sequence_for<Args...>{});
+		}
+
+		const CharType* c_str() const
+		{
+			return str_;
+		}
+
+		// one per argument and one more for the literal text after the last field
+		const detail::format_field<CharType>* fields() const
+		{
+			return fields_;
+		}
+
+		// characters of literal text, doubled braces count once
+		size_t literal_size() const
+		{
+			return literal_size_;
+		}
+
+	private:
+		constexpr void parse(size_t size)
+		{
+			size_t field = 0;
+			size_t literal_begin = 0;
+			size_t escapes = 0;
+
+			for (size_t i = 0; i < size; ++i)
+			{
+				const auto c = str_[i];
+				if ((c == '{' || c == '}') && i + 1 < size && str_[i + 1] == c)
+				{
+					++escapes;
+					++i;
+					continue;
+				}
+
+				if (c == '}')
+					detail::format_string_error("unmatched '}' in format string, write }} for a brace");
+
+				if (c != '{')
+					continue;
+
+				if (field == sizeof...(Args))
+					detail::format_string_error("format string has more replacement fields than arguments");
+
+				end_literal(fields_[field], literal_begin, i, escapes);
+				i = parse_spec(i + 1, size, fields_[field].spec);
+				literal_begin = i + 1;
+				escapes = 0;
+				++field;
+			}
+
+			if (field != sizeof...(Args))
+				detail::format_string_error("format string has fewer replacement fields than arguments");
+
+			end_literal(fields_[field], literal_begin, size, escapes);
+		}
+
+		constexpr void end_literal(detail::format_field<CharType>& field, size_t begin, size_t end, size_t escapes)
+		{
+			field.literal = { static_cast<uint32_t>(begin), static_cast<uint32_t>(end - begin), escapes != 0 };
+			literal_size_ += end - begin - escapes;
+		}
+
+		// i is past the '{', returns the index of the closing '}'
+		constexpr size_t parse_spec(size_t i, size_t size, detail::format_spec<CharType>& spec) const
+		{
+			if (i < size && str_[i] == '}')
+				return i;
+
+			if (i >= size || str_[i] != ':')
+				detail::format_string_error("replacement fields are {} or {:spec}, argument indices are not supported");
+
+			++i;
+			if (i + 1 < size && detail::to_format_align(str_[i + 1]) != detail::format_align::none && str_[i] != '{' && str_[i] != '}')
+			{
+				spec.fill = str_[i];
+				spec.align = detail::to_format_align(str_[i + 1]);
+				i += 2;
+			}
+			else if (i < size && detail::to_format_align(str_[i]) != detail::format_align::none)
+			{
+				spec.align = detail::to_format_align(str_[i]);
+				++i;
+			}
+
+			if (i < size && str_[i] == '0')
 			{
-				final_string = move(token_string);
+				spec.zero_pad = true;
+				++i;
 			}
 
-			const auto right_substr_size = end - (token_end + 1);
-			if (right_substr_size > 0)
+			for (; i < size && detail::is_format_digit(str_[i]); ++i)
 			{
-				final_string += token_end + 1;
+				spec.width = spec.width * 10 + (str_[i] - '0');
+				if (spec.width > detail::max_format_width)
+					detail::format_string_error("format width is too large");
 			}
 
-			return detail::do_format_replace(&*final_string.begin(), &*final_string.end(), tokens...);
+			if (i < size && str_[i] == '.')
+			{
+				if (++i >= size || !detail::is_format_digit(str_[i]))
+					detail::format_string_error("missing precision after '.'");
+
+				spec.precision = 0;
+				for (; i < size && detail::is_format_digit(str_[i]); ++i)
+				{
+					spec.precision = spec.precision * 10 + (str_[i] - '0');
+					if (spec.precision > static_cast<int32_t>(detail::max_format_width))
+						detail::format_string_error("format precision is too large");
+				}
+			}
+
+			if (i < size && str_[i] != '}')
+			{
+				if (str_[i] < 'A' || str_[i] > 'z')
+					detail::format_string_error("unknown format type");
+
+				spec.type = static_cast<char>(str_[i++]);
+			}
+
+			if (i >= size || str_[i] != '}')
+				detail::format_string_error("unterminated replacement field");
+
+			return i;
+		}
+
+		template <size_t... I>
+		constexpr void check_fields(std::index_sequence<I...>)
+		{
+			(detail::check_format_spec<CharType, Args>(fields_[I].spec), ...);
 		}
+
+		const CharType* str_{};
+		detail::format_field<CharType> fields_[sizeof...(Args) + 1]{};
+		size_t literal_size_{};
+	};
+
+	template <typename... Types>
+	using format_string = basic_format_string<char, std::type_identity_t<Types>...>;
+
+	namespace detail
+	{
+		// the characters of one argument, the padding is added when it is written
+		template <typename CharType, typename T>
+		string_piece<CharType> make_format_piece(const T& value, const format_spec<CharType>& spec)
+		{
+			using type = std::decay_t<T>;
+			constexpr auto kind = format_kind_of<CharType, type>();
+
+			if constexpr (kind == format_kind::integer)
+			{
+				if (spec.type != 'x' && spec.type != 'X')
+					return make_piece<CharType>(value);
+
+				// the bits of negative values, like int_to_hex
+				auto piece = make_piece<CharType>(hex(value));
+				if (spec.type == 'x')
+				{
+					for (size_t i = 0; i < piece.size; ++i)
+					{
+						if (piece.inline_buffer[i] >= 'A')
+							piece.inline_buffer[i] |= 0x20;
+					}
+				}
+
+				return piece;
+			}
+			else if constexpr (kind == format_kind::floating)
+			{
+				if (spec.precision >= 0)
+					return make_float_piece<CharType>(value, static_cast<size_t>(spec.precision));
+
+				// 6 decimals like printf("%f")
+				return spec.type == 'f' ? make_float_piece<CharType>(value, 6) : make_piece<CharType>(value);
+			}
+			else if constexpr (kind == format_kind::text)
+			{
+				auto piece = make_piece<CharType>(value);
+				if (spec.precision >= 0 && piece.size > static_cast<size_t>(spec.precision))
+					piece.size = static_cast<size_t>(spec.precision);
+
+				return piece;
+			}
+			else if constexpr (kind == format_kind::pointer)
+			{
+				return make_piece<CharType>(hex(reinterpret_cast<uintptr_t>(value)));
+			}
+			else
+			{
+				return make_piece<CharType>(value);
+			}
+		}
+
+		// every argument formatted, and the size of the whole output
+		template <typename CharType, size_t Count>
+		struct format_arguments
+		{
+			string_piece<CharType> pieces[Count];
+			size_t size;
+		};
+
+		template <typename CharType, typename... Args, size_t... I, typename... Types>
+		void make_format_pieces(format_arguments<CharType, sizeof...(Types)>& arguments, const basic_format_string<CharType, Args...>& fmt,
+			std::index_sequence<I...>, const Types&... values)
+		{
+			const auto fields = fmt.fields();
+			((arguments.pieces[I] = make_format_piece<CharType>(values, fields[I].spec)), ...);
+
+			arguments.size = fmt.literal_size();
+			for (size_t i = 0; i < sizeof...(Types); ++i)
+			{
+				const auto& piece = arguments.pieces[i];
+				arguments.size += piece.size > fields[i].spec.width ? piece.size : fields[i].spec.width;
+			}
+		}
+
+		template <typename CharType, typename... Args, typename... Types>
+		format_arguments<CharType, sizeof...(Types)> format_arguments_of(const basic_format_string<CharType, Args...>& fmt, const Types&... values)
+		{
+			format_arguments<CharType, sizeof...(Types)> arguments;
+			make_format_pieces(arguments, fmt, std::index_sequence_for<Types...>{}, values...);
+			return arguments;
+		}
+
+		// where the output goes: write copies characters, fill repeats one
+		template <typename CharType>
+		struct pointer_format_sink
+		{
+			CharType* out;
+
+			void write(const CharType* text, size_t size)
+			{
+				memcpy(out, text, size * sizeof(CharType));
+				out += size;
+			}
+
+			void fill(CharType c, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+					*out++ = c;
+			}
+		};
+
+		template <typename OutputIt>
+		struct iterator_format_sink
+		{
+			OutputIt out;
+
+			template <typename CharType>
+			void write(const CharType* text, size_t size)
+			{
+				for (size_t i = 0; i < size; ++i)
+					*out++ = text[i];
+			}
+
+			template <typename CharType>
+			void fill(CharType c, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+					*out++ = c;
+			}
+		};
+
+		// drops everything past the first left characters
+		template <typename OutputIt>
+		struct limited_format_sink
+		{
+			OutputIt out;
+			size_t left;
+
+			template <typename CharType>
+			void write(const CharType* text, size_t size)
+			{
+				if (size > left)
+					size = left;
+
+				for (size_t i = 0; i < size; ++i)
+					*out++ = text[i];
+
+				left -= size;
+			}
+
+			template <typename CharType>
+			void fill(CharType c, size_t count)
+			{
+				if (count > left)
+					count = left;
+
+				for (size_t i = 0; i < count; ++i)
+					*out++ = c;
+
+				left -= count;
+			}
+		};
+
+		// appends to a vector that already has the capacity for the output
+		template <typename CharType>
+		struct vector_format_sink
+		{
+			vector<CharType>& buffer;
+
+			void write(const CharType* text, size_t size)
+			{
+				buffer.insert(buffer.end(), text, size);
+			}
+
+			void fill(CharType c, size_t count)
+			{
+				for (size_t i = 0; i < count; ++i)
+					buffer.push_back(c);
+			}
+		};
+
+		// escaped segments still hold both characters of every doubled brace, the second one is skipped
+		template <typename CharType, typename Sink>
+		void write_format_literal(Sink& sink, const CharType* str, const format_segment& segment)
+		{
+			const auto text = str + segment.offset;
+			if (!segment.escaped)
+			{
+				sink.write(text, segment.size);
+				return;
+			}
+
+			uint32_t begin = 0;
+			for (uint32_t i = 0; i < segment.size; ++i)
+			{
+				if (text[i] == '{' || text[i] == '}')
+				{
+					sink.write(text + begin, i + 1 - begin);
+					begin = ++i + 1;
+				}
+			}
+
+			sink.write(text + begin, segment.size - begin);
+		}
+
+		template <typename CharType, typename Sink>
+		void write_format_field(Sink& sink, const string_piece<CharType>& piece, const format_spec<CharType>& spec)
+		{
+			auto text = piece.data();
+			auto size = piece.size;
+			const auto padding = spec.width > size ? spec.width - size : 0;
+
+			if (spec.zero_pad)
+			{
+				if (size && *text == '-')
+				{
+					sink.write(text++, 1);
+					--size;
+				}
+
+				sink.fill(static_cast<CharType>('0'), padding);
+				sink.write(text, size);
+				return;
+			}
+
+			const auto before = spec.align == format_align::right ? padding : spec.align == format_align::center ? padding / 2 : 0;
+			sink.fill(spec.fill, before);
+			sink.write(text, size);
+			sink.fill(spec.fill, padding - before);
+		}
+
+		// writes exactly arguments.size characters
+		template <typename CharType, typename... Args, size_t Count, typename Sink>
+		void write_format(Sink& sink, const basic_format_string<CharType, Args...>& fmt, const format_arguments<CharType, Count>& arguments)
+		{
+			const auto fields = fmt.fields();
+			for (size_t i = 0; i < Count; ++i)
+			{
+				write_format_literal(sink, fmt.c_str(), fields[i].literal);
+				write_format_field(sink, arguments.pieces[i], fields[i].spec);
+			}
+
+			write_format_literal(sink, fmt.c_str(), fields[Count].literal);
+		}
+	}
+
+	// formatted text in an inline buffer, only output of Capacity characters or more is allocated.
+	// always null terminated, LOG_CONSOLE formats into one of these on the stack.
+	template <typename CharType, size_t Capacity>
+	class basic_format_buffer
+	{
+	public:
+		static_assert(Capacity > 0, "format_buffer needs room for the null terminator");
+
+		const CharType* c_str() const
+		{
+			return size_ < Capacity ? inline_buffer_ : heap_.c_str();
+		}
+
+		size_t size() const
+		{
+			return size_;
+		}
+
+		bool empty() const
+		{
+			return !size_;
+		}
+
+		// room for count more characters at the end, returns where they go
+		CharType* extend(size_t count)
+		{
+			const auto old_size = size_;
+			size_ += count;
+
+			if (size_ < Capacity)
+			{
+				inline_buffer_[size_] = 0;
+				return inline_buffer_ + old_size;
+			}
+
+			if (old_size < Capacity)
+				heap_.assign(inline_buffer_, old_size);
+
+			heap_.resize(size_);
+			return heap_.c_str() + old_size;
+		}
+
+		void append(const CharType* str, size_t size)
+		{
+			memcpy(extend(size), str, size * sizeof(CharType));
+		}
+
+		void clear()
+		{
+			size_ = 0;
+			inline_buffer_[0] = 0;
+		}
+
+	private:
+		CharType inline_buffer_[Capacity]{};
+		base_string<CharType> heap_{};
+		size_t size_{};
+	};
+
+	template <size_t Capacity = 256>
+	using format_buffer = basic_format_buffer<char, Capacity>;
+
+	namespace detail
+	{
+		// containers the format_to overloads append to instead of treating them as output iterators
+		template <typename T>
+		struct is_format_buffer : std::false_type
+		{
+		};
+
+		template <typename CharType>
+		struct is_format_buffer<vector<CharType>> : std::true_type
+		{
+		};
+
+		template <typename CharType>
+		struct is_format_buffer<base_string<CharType>> : std::true_type
+		{
+		};
+
+		template <typename CharType, size_t Capacity>
+		struct is_format_buffer<basic_format_buffer<CharType, Capacity>> : std::true_type
+		{
+		};
+	}
+
+	template <typename OutputIt>
+	struct format_to_n_result
+	{
+		OutputIt out;		// past the last written character
+		size_t size;		// the size of the whole output, more than n when it was cut
+	};
+
+	// format("{} took {:.3f}ms, flags {:08X}", name, ms, flags). integers are decimal unless the spec asks for
+	// hex, like concat. the string is parsed at compile time, a field count or a spec that does not match the
+	// arguments fails the compilation. the arguments are formatted on the stack and the result is allocated once.
+	template <typename T, typename... Types>
+	string format(format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		const auto arguments = detail::format_arguments_of(fmt, value, values...);
+
+		string result;
+		result.reserve(arguments.size);
+		result.resize(arguments.size);
+
+		detail::pointer_format_sink<char> sink{ result.c_str() };
+		detail::write_format(sink, fmt, arguments);
+		return result;
 	}
 
-	// format("My name is {}, hello from {}", "Jane", "USA") == "My name is Jane, hello from USA"
+	// the number of characters format would produce, without producing them
 	template <typename T, typename... Types>
-	crt::string format(const char* fmt, T token, Types... tokens)
+	size_t formatted_size(format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		return detail::format_arguments_of(fmt, value, values...).size;
+	}
+
+	// writes through an output iterator or into a character buffer big enough for formatted_size characters,
+	// no null terminator. returns past the last written character.
+	template <typename OutputIt, typename T, typename... Types>
+	std::enable_if_t<!detail::is_format_buffer<OutputIt>::value, OutputIt> format_to(OutputIt out, format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		const auto arguments = detail::format_arguments_of(fmt, value, values...);
+
+		if constexpr (std::is_same_v<OutputIt, char*>)
+		{
+			detail::pointer_format_sink<char> sink{ out };
+			detail::write_format(sink, fmt, arguments);
+			return sink.out;
+		}
+		else
+		{
+			detail::iterator_format_sink<OutputIt> sink{ out };
+			detail::write_format(sink, fmt, arguments);
+			return sink.out;
+		}
+	}
+
+	// at most n characters, the rest of the output is dropped. no null terminator
+	template <typename OutputIt, typename T, typename... Types>
+	format_to_n_result<OutputIt> format_to_n(OutputIt out, size_t n, format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		const auto arguments = detail::format_arguments_of(fmt, value, values...);
+
+		if constexpr (std::is_same_v<OutputIt, char*>)
+		{
+			if (arguments.size <= n)
+			{
+				detail::pointer_format_sink<char> sink{ out };
+				detail::write_format(sink, fmt, arguments);
+				return { sink.out, arguments.size };
+			}
+		}
+
+		detail::limited_format_sink<OutputIt> sink{ out, n };
+		detail::write_format(sink, fmt, arguments);
+		return { sink.out, arguments.size };
+	}
+
+	// the appending overloads grow the buffer once and write the output at its end
+	template <typename T, typename... Types>
+	void format_to(vector<char>& buffer, format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		const auto arguments = detail::format_arguments_of(fmt, value, values...);
+		buffer.reserve(buffer.size() + arguments.size);
+
+		detail::vector_format_sink<char> sink{ buffer };
+		detail::write_format(sink, fmt, arguments);
+	}
+
+	template <typename T, typename... Types>
+	void format_to(string& buffer, format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		const auto arguments = detail::format_arguments_of(fmt, value, values...);
+		const auto old_size = buffer.size();
+		buffer.resize(old_size + arguments.size);
+
+		detail::pointer_format_sink<char> sink{ buffer.c_str() + old_size };
+		detail::write_format(sink, fmt, arguments);
+	}
+
+	template <size_t Capacity, typename T, typename... Types>
+	void format_to(format_buffer<Capacity>& buffer, format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		const auto arguments = detail::format_arguments_of(fmt, value, values...);
+
+		detail::pointer_format_sink<char> sink{ buffer.extend(arguments.size) };
+		detail::write_format(sink, fmt, arguments);
+	}
+
+	// format into a buffer on the stack: windows::print(crt::format_inline<256>("{} items", count).c_str())
+	template <size_t Capacity, typename T, typename... Types>
+	format_buffer<Capacity> format_inline(format_string<T, Types...> fmt, const T& value, const Types&... values)
+	{
+		format_buffer<Capacity> buffer;
+		format_to(buffer, fmt, value, values...);
+		return buffer;
+	}
+
+	// without arguments the text is copied as it is, like format
+	template <size_t Capacity>
+	format_buffer<Capacity> format_inline(const char* str)
+	{
+		format_buffer<Capacity> buffer;
+		buffer.append(str, strlen(str));
+		return buffer;
+	}
+
+	template <size_t Capacity>
+	format_buffer<Capacity> format_inline(const string& str)
 	{
-		crt::string buffer{ fmt };
-		return detail::do_format_replace(&*buffer.begin(), &*buffer.end(), crt::move(token), std::forward<Types>(tokens)...);
+		format_buffer<Capacity> buffer;
+		buffer.append(str.c_str(), str.size());
+		return buffer;
 	}
 
 	inline crt::string format(const char* fmt)
@@ -64,4 +766,4 @@ namespace crt
 		return fmt;
 	}
 
-}
\ No newline at end of file
+}
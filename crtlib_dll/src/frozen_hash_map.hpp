@@ -0,0 +1,287 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+#include "my_memory.h"
+#include "my_string.hpp"
+#include "my_vector.hpp"
+#include "hash_table.hpp"
+#include "result.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		template <typename T>
+		struct is_base_string : std::false_type {};
+
+		template <typename CharType>
+		struct is_base_string<base_string<CharType>> : std::true_type {};
+
+		constexpr uint32_t frozen_magic = 0x4E5A5246; // "FRZN"
+		constexpr uint32_t frozen_version = 2;
+		constexpr size_t frozen_section_alignment = 64;
+
+		// all offsets are relative to the start of the header, the format contains no pointers
+		struct frozen_header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t hash_size;			// sizeof(size_t) of the writer, hashes are only valid for the same width
+			uint32_t key_size;			// sizeof(K) for integral keys, sizeof(CharType) for string keys
+			uint32_t value_size;
+			uint32_t value_alignment;
+			uint64_t entry_count;
+			uint64_t slot_count;		// power of 2
+			uint64_t slots_offset;
+			uint64_t values_offset;
+			uint64_t strings_offset;	// characters of string keys, not null terminated
+			uint64_t strings_size;
+			uint64_t file_size;
+		};
+
+		struct frozen_slot
+		{
+			uint64_t hash;
+			uint64_t key;			// integral key, or offset of the characters in the strings section
+			uint32_t key_length;	// number of characters for string keys
+			uint32_t value_index;	// empty_slot if unused
+		};
+
+		constexpr uint32_t frozen_empty_slot = 0xFFFFFFFF;
+
+		constexpr uint64_t frozen_align(uint64_t offset)
+		{
+			return (offset + frozen_section_alignment - 1) & ~(frozen_section_alignment - 1);
+		}
+	}
+
+	// immutable hash table stored in a flat, pointer free format that is queried in place, without deserialization.
+	// the table is written once with serialize() and later opened on top of a mapping of the file:
+	//
+	// windows::write_file(crt::frozen_hash_map<crt::string, uint32_t>::serialize(map), path, windows::overwrite);
+	// ...
+	// auto file = windows::map_file(path);
+	// auto table = crt::frozen_hash_map<crt::string, uint32_t>::open(file->data(), file->size());
+	// const uint32_t* value = table->find("key", 3);
+	//
+	// layout: [header][slots: open addressing, linear probing][values][key characters], sections 64 byte aligned.
+	// keys are integral/enum types or crt::string/crt::wstring, values must be trivially copyable.
+	// the view does not own the memory, it must outlive the frozen_hash_map.
+	template <typename K, typename V>
+	class frozen_hash_map
+	{
+		static_assert(std::is_trivially_copyable_v<V>, "frozen_hash_map values must be trivially copyable");
+		static_assert(std::is_integral_v<K> || std::is_enum_v<K> || detail::is_base_string<K>::value,
+			"frozen_hash_map keys must be integral, enum or crt::base_string");
+
+		constexpr static bool string_keys = detail::is_base_string<K>::value;
+
+		template <typename T, bool IsString = detail::is_base_string<T>::value>
+		struct key_element
+		{
+			using type = T;
+		};
+
+		template <typename T>
+		struct key_element<T, true>
+		{
+			using type = typename T::value_type;
+		};
+
+		// character type for string keys, K itself for integral keys
+		using key_element_t = typename key_element<K>::type;
+
+	public:
+		using t_open_result = crt::result<frozen_hash_map, crt::string>;
+
+		frozen_hash_map() = default;
+
+		// validate the header and section bounds of the serialized table at data. no copies are made.
+		static t_open_result open(const void* data, size_t size)
+		{
+			const auto bytes = static_cast<const uint8_t*>(data);
+			const auto header = reinterpret_cast<const detail::frozen_header*>(bytes);
+
+			if (!bytes || size < sizeof(detail::frozen_header))
+				return t_open_result::error(crt::string("Frozen table is truncated!"));
+
+			if ((uintptr_t)bytes % alignof(detail::frozen_slot) || (uintptr_t)bytes % alignof(V))
+				return t_open_result::error(crt::string("Frozen table is misaligned!"));
+
+			if (header->magic != detail::frozen_magic || header->version != detail::frozen_version)
+				return t_open_result::error(crt::string("Not a frozen table or unsupported version!"));
+
+			if (header->hash_size != sizeof(size_t) || header->key_size != sizeof(key_element_t) ||
+				header->value_size != sizeof(V) || header->value_alignment != alignof(V))
+				return t_open_result::error(crt::string("Frozen table was written for different types!"));
+
+			const auto slot_count = header->slot_count;
+			if (!slot_count || (slot_count & (slot_count - 1)) || header->entry_count > slot_count || header->file_size > size)
+				return t_open_result::error(crt::string("Frozen table header is corrupt!"));
+
+			if (header->slots_offset > size || slot_count > (size - header->slots_offset) / sizeof(detail::frozen_slot) ||
+				header->values_offset > size || header->entry_count > (size - header->values_offset) / sizeof(V) ||
+				header->strings_offset > size || header->strings_size > size - header->strings_offset)
+				return t_open_result::error(crt::string("Frozen table section is out of bounds!"));
+
+			frozen_hash_map table;
+			table.header_ = header;
+			table.slots_ = reinterpret_cast<const detail::frozen_slot*>(bytes + header->slots_offset);
+			table.values_ = reinterpret_cast<const V*>(bytes + header->values_offset);
+			table.strings_ = reinterpret_cast<const key_element_t*>(bytes + header->strings_offset);
+			return t_open_result::ok(table);
+		}
+
+		// returns nullptr if the key does not exist
+		const V* find(const K& key) const
+		{
+			if constexpr (string_keys)
+				return find(key.c_str(), key.size());
+			else
+				return find_hashed(crt::get_hash(key), [&key](const detail::frozen_slot& slot)
+				{
+					return static_cast<K>(slot.key) == key;
+				});
+		}
+
+		// lookup by non null terminated string, does not allocate
+		template <typename CharType, typename Key = K>
+		std::enable_if_t<detail::is_base_string<Key>::value && std::is_same_v<typename Key::value_type, CharType>, const V*>
+			find(const CharType* key, size_t length) const
+		{
+			return find_hashed(crt::get_string_hash(key, length), [this, key, length](const detail::frozen_slot& slot)
+			{
+				// bounds are checked here instead of in open(), so opening stays O(1)
+				if (slot.key_length != length || slot.key > header_->strings_size / sizeof(CharType) ||
+					length > header_->strings_size / sizeof(CharType) - slot.key)
+					return false;
+
+				return !memcmp(strings_ + slot.key, key, length * sizeof(CharType));
+			});
+		}
+
+		bool contains(const K& key) const
+		{
+			return find(key) != nullptr;
+		}
+
+		size_t size() const
+		{
+			return header_ ? static_cast<size_t>(header_->entry_count) : 0;
+		}
+
+		bool empty() const
+		{
+			return size() == 0;
+		}
+
+		// write the contents of map in the frozen format
+		static crt::vector<uint8_t> serialize(const hash_map<K, V>& map)
+		{
+			const size_t entry_count = map.size();
+
+			// keep the load factor at or below 0.5 so that probe sequences stay short
+			uint64_t slot_count = 1;
+			while (slot_count < entry_count * 2)
+				slot_count <<= 1;
+
+			uint64_t strings_size = 0;
+			if constexpr (string_keys)
+			{
+				for (auto entry : map)
+					strings_size += entry.first()->size() * sizeof(key_element_t);
+			}
+
+			detail::frozen_header header{};
+			header.magic = detail::frozen_magic;
+			header.version = detail::frozen_version;
+			header.hash_size = sizeof(size_t);
+			header.key_size = sizeof(key_element_t);
+			header.value_size = sizeof(V);
+			header.value_alignment = alignof(V);
+			header.entry_count = entry_count;
+			header.slot_count = slot_count;
+			header.slots_offset = detail::frozen_align(sizeof(detail::frozen_header));
+			header.values_offset = detail::frozen_align(header.slots_offset + slot_count * sizeof(detail::frozen_slot));
+			header.strings_offset = detail::frozen_align(header.values_offset + entry_count * sizeof(V));
+			header.strings_size = strings_size;
+			header.file_size = header.strings_offset + strings_size;
+
+			crt::vector<uint8_t> bytes(static_cast<size_t>(header.file_size), 0);
+			const auto data = bytes.data();
+
+			memcpy(data, &header, sizeof(header));
+
+			const auto slots = reinterpret_cast<detail::frozen_slot*>(data + header.slots_offset);
+			for (uint64_t i = 0; i < slot_count; ++i)
+				slots[i].value_index = detail::frozen_empty_slot;
+
+			uint32_t value_index = 0;
+			uint64_t string_offset = 0; // in characters
+
+			for (auto entry : map)
+			{
+				const K& key = *entry.first();
+				const auto hash = static_cast<uint64_t>(crt::get_hash(key));
+
+				auto position = hash & (slot_count - 1);
+				while (slots[position].value_index != detail::frozen_empty_slot)
+					position = (position + 1) & (slot_count - 1);
+
+				auto& slot = slots[position];
+				slot.hash = hash;
+				slot.value_index = value_index;
+
+				if constexpr (string_keys)
+				{
+					slot.key = string_offset;
+					slot.key_length = static_cast<uint32_t>(key.size());
+
+					memcpy(data + header.strings_offset + string_offset * sizeof(key_element_t), key.c_str(), key.size() * sizeof(key_element_t));
+					string_offset += key.size();
+				}
+				else
+				{
+					slot.key = static_cast<uint64_t>(key);
+				}
+
+				memcpy(data + header.values_offset + value_index * sizeof(V), entry.second(), sizeof(V));
+				++value_index;
+			}
+
+			return bytes;
+		}
+
+	private:
+		template <typename F>
+		const V* find_hashed(size_t key_hash, F key_equals) const
+		{
+			if (!header_ || !header_->entry_count)
+				return nullptr;
+
+			const auto hash = static_cast<uint64_t>(key_hash);
+			const auto mask = header_->slot_count - 1;
+
+			auto position = hash & mask;
+			for (uint64_t probe_index = 0; probe_index <= mask; ++probe_index, position = (position + 1) & mask)
+			{
+				const auto& slot = slots_[position];
+
+				// the load factor is at most 0.5, an empty slot ends the search
+				if (slot.value_index == detail::frozen_empty_slot)
+					return nullptr;
+
+				if (slot.hash == hash && key_equals(slot))
+					return slot.value_index < header_->entry_count ? &values_[slot.value_index] : nullptr;
+			}
+
+			return nullptr;
+		}
+
+		const detail::frozen_header* header_{};
+		const detail::frozen_slot* slots_{};
+		const V* values_{};
+		const key_element_t* strings_{};
+	};
+}
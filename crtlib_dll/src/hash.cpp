@@ -0,0 +1,77 @@
+#include "hash.hpp"
+#include <emmintrin.h>
+
+namespace crt
+{
+	namespace detail
+	{
+		constexpr size_t hash_stripe_size = 64;
+		constexpr size_t hash_stripes_per_block = 16;	// the secret window moves 8 bytes per stripe, 64 + 15 * 8 bytes of secret
+		constexpr uint32_t hash_scramble_prime = 0x9E3779B1u;
+
+		// acc += swap_lanes(data) + low32(data ^ secret) * high32(data ^ secret), per 64 bit lane
+		static void accumulate_stripe(__m128i (&acc)[4], const uint8_t* data, const uint8_t* secret)
+		{
+			for (int i = 0; i < 4; ++i)
+			{
+				const auto data_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data) + i);
+				const auto key_vec = _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i);
+
+				const auto data_key = _mm_xor_si128(data_vec, key_vec);
+				const auto product = _mm_mul_epu32(data_key, _mm_shuffle_epi32(data_key, _MM_SHUFFLE(2, 3, 0, 1)));
+
+				// adding the raw data keeps it from being cancelled when data ^ secret has a zero half
+				const auto swapped = _mm_shuffle_epi32(data_vec, _MM_SHUFFLE(1, 0, 3, 2));
+				acc[i] = _mm_add_epi64(acc[i], _mm_add_epi64(product, swapped));
+			}
+		}
+
+		// spread the high bits of the accumulators back into the low bits that feed the next multiplications
+		static void scramble(__m128i (&acc)[4], const uint8_t* secret)
+		{
+			const auto prime = _mm_set1_epi32(static_cast<int32_t>(hash_scramble_prime));
+
+			for (int i = 0; i < 4; ++i)
+			{
+				auto value = _mm_xor_si128(acc[i], _mm_srli_epi64(acc[i], 47));
+				value = _mm_xor_si128(value, _mm_loadu_si128(reinterpret_cast<const __m128i*>(secret) + i));
+
+				// 64 bit lane * 32 bit prime out of two 32x32 -> 64 bit products
+				const auto low = _mm_mul_epu32(value, prime);
+				const auto high = _mm_mul_epu32(_mm_srli_epi64(value, 32), prime);
+				acc[i] = _mm_add_epi64(low, _mm_slli_epi64(high, 32));
+			}
+		}
+
+		uint64_t hash_bytes_long(const uint8_t* data, size_t size, uint64_t seed)
+		{
+			const auto secret = reinterpret_cast<const uint8_t*>(hash_secret);
+
+			__m128i acc[4];
+			for (int i = 0; i < 4; ++i)
+				acc[i] = _mm_set_epi64x(static_cast<int64_t>(hash_secret[2 * i + 1] ^ seed), static_cast<int64_t>(hash_secret[2 * i] + seed));
+
+			const auto stripe_count = size / hash_stripe_size;
+			for (size_t stripe = 0; stripe < stripe_count; ++stripe)
+			{
+				const auto stripe_in_block = stripe % hash_stripes_per_block;
+				accumulate_stripe(acc, data + stripe * hash_stripe_size, secret + stripe_in_block * 8);
+
+				if (stripe_in_block == hash_stripes_per_block - 1)
+					scramble(acc, secret + sizeof(hash_secret) - hash_stripe_size);
+			}
+
+			alignas(16) uint64_t lanes[8];
+			for (int i = 0; i < 4; ++i)
+				_mm_store_si128(reinterpret_cast<__m128i*>(lanes) + i, acc[i]);
+
+			uint64_t result = size * 0x9E3779B185EBCA87ull;
+			for (int i = 0; i < 4; ++i)
+				result += hash_multiply_fold(lanes[2 * i] ^ hash_secret[8 + 2 * i], lanes[2 * i + 1] ^ hash_secret[9 + 2 * i]);
+
+			// the bytes after the last full stripe go through the short path, seeded with the accumulated state
+			const auto consumed = stripe_count * hash_stripe_size;
+			return hash_bytes(data + consumed, size - consumed, hash_mix(result));
+		}
+	}
+}
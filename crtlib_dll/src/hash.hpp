@@ -1,5 +1,9 @@
 #pragma once
+#include <cstdint>
 #include <type_traits>
+#ifdef _WIN64
+#include <intrin.h>
+#endif
 
 #include "c_string.hpp"
 #include "pair.hpp"
@@ -29,25 +33,175 @@ namespace crt
 		return hash;
 	}
 
+	namespace detail
+	{
+		// random constants for hash_bytes, the long input path reads a sliding window of them per stripe
+		inline constexpr uint64_t hash_secret[24] =
+		{
+			0x2cb0f69f4abea221ull, 0x9417034723148989ull, 0xdd555950609dfe03ull, 0xdbafb150deb12800ull,
+			0x7e789b2e6c442cb6ull, 0xf41e5636c7e4f8c4ull, 0x0959d150f8fba7e4ull, 0xa97316f13cdb9eeaull,
+			0x74cd8258f9520068ull, 0x55c74a62e116868bull, 0xd2f4c799a2023cbdull, 0xdf98cb79a37b51b9ull,
+			0x396f5885524f3905ull, 0xaf1d56386ca3b276ull, 0xa9ffbe6b5104e85aull, 0x6bd0c51b9fd533b3ull,
+			0x980ce91c50ab4b56ull, 0x28ac395780fe62c5ull, 0x768912e3a6bcedc7ull, 0x50b3e8c9332c7c88ull,
+			0xce3bbfe520bd47daull, 0xcba6c8e8e0bb7c4full, 0xbf194db8434a346dull, 0x7d8f2a7b60416d7full,
+		};
+
+		// full 64x64 -> 128 bit multiply, a receives the low and b the high half of the product
+		constexpr void hash_multiply(uint64_t& a, uint64_t& b)
+		{
+#ifdef _WIN64
+			if (!std::is_constant_evaluated())
+			{
+				a = _umul128(a, b, &b);
+				return;
+			}
+#endif
+			const uint64_t a_low = a & 0xFFFFFFFF, a_high = a >> 32;
+			const uint64_t b_low = b & 0xFFFFFFFF, b_high = b >> 32;
+
+			const uint64_t low_low = a_low * b_low;
+			const uint64_t high_low = a_high * b_low;
+			const uint64_t low_high = a_low * b_high;
+			const uint64_t high_high = a_high * b_high;
+
+			const uint64_t cross = (low_low >> 32) + (high_low & 0xFFFFFFFF) + low_high;
+			b = high_high + (high_low >> 32) + (cross >> 32);
+			a = (cross << 32) | (low_low & 0xFFFFFFFF);
+		}
+
+		// 128 bit product folded by xoring the halves
+		constexpr uint64_t hash_multiply_fold(uint64_t a, uint64_t b)
+		{
+			hash_multiply(a, b);
+			return a ^ b;
+		}
+
+		inline uint64_t read_u64(const uint8_t* p)
+		{
+			return *reinterpret_cast<const uint64_t*>(p);
+		}
+
+		inline uint64_t read_u32(const uint8_t* p)
+		{
+			return *reinterpret_cast<const uint32_t*>(p);
+		}
+
+		// inputs of at least hash_long_threshold bytes, sse2 accumulation over 64 byte stripes. see hash.cpp
+		uint64_t hash_bytes_long(const uint8_t* data, size_t size, uint64_t seed);
+
+		constexpr size_t hash_long_threshold = 256;
+
+		constexpr size_t fold_hash(uint64_t hash)
+		{
+#ifdef _WIN64
+			return static_cast<size_t>(hash);
+#else
+			return static_cast<size_t>(hash ^ (hash >> 32));
+#endif
+		}
+	}
+
+	// bijective 64 bit mixer (moremur). every input bit affects every output bit, so patterned integer keys
+	// (multiples of a power of 2, pointers, ids) spread over the whole table instead of colliding on the modulo.
+	constexpr uint64_t hash_mix(uint64_t x)
+	{
+		x ^= x >> 27;
+		x *= 0x3C79AC492BA7B653ull;
+		x ^= x >> 33;
+		x *= 0x1C69B3F74AC4AE35ull;
+		x ^= x >> 27;
+		return x;
+	}
+
+	// wyhash style hash of a byte buffer. 16 bytes are consumed per 64x64 -> 128 bit multiply,
+	// 48 bytes per iteration with three independent lanes, and inputs of hash_long_threshold bytes or more
+	// go through an sse2 path that consumes 64 bytes per step.
+	inline uint64_t hash_bytes(const void* data, size_t size, uint64_t seed = 0)
+	{
+		using detail::hash_secret;
+		using detail::hash_multiply_fold;
+
+		auto p = static_cast<const uint8_t*>(data);
+
+		if (size >= detail::hash_long_threshold)
+			return detail::hash_bytes_long(p, size, seed);
+
+		seed ^= hash_multiply_fold(seed ^ hash_secret[0], hash_secret[1]);
+
+		uint64_t a, b;
+		if (size <= 16)
+		{
+			if (size >= 4)
+			{
+				// two overlapping reads of 4 bytes from each end cover 4..16 bytes
+				const auto offset = (size >> 3) << 2;
+				a = (detail::read_u32(p) << 32) | detail::read_u32(p + offset);
+				b = (detail::read_u32(p + size - 4) << 32) | detail::read_u32(p + size - 4 - offset);
+			}
+			else if (size > 0)
+			{
+				a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[size >> 1]) << 8) | p[size - 1];
+				b = 0;
+			}
+			else
+			{
+				a = b = 0;
+			}
+		}
+		else
+		{
+			auto remaining = size;
+			if (remaining > 48)
+			{
+				auto seed1 = seed;
+				auto seed2 = seed;
+				do
+				{
+					seed = hash_multiply_fold(detail::read_u64(p) ^ hash_secret[1], detail::read_u64(p + 8) ^ seed);
+					seed1 = hash_multiply_fold(detail::read_u64(p + 16) ^ hash_secret[2], detail::read_u64(p + 24) ^ seed1);
+					seed2 = hash_multiply_fold(detail::read_u64(p + 32) ^ hash_secret[3], detail::read_u64(p + 40) ^ seed2);
+					p += 48;
+					remaining -= 48;
+				} while (remaining > 48);
+
+				seed ^= seed1 ^ seed2;
+			}
+
+			while (remaining > 16)
+			{
+				seed = hash_multiply_fold(detail::read_u64(p) ^ hash_secret[1], detail::read_u64(p + 8) ^ seed);
+				p += 16;
+				remaining -= 16;
+			}
+
+			// the last 16 bytes, overlapping already hashed ones if needed
+			a = detail::read_u64(p + remaining - 16);
+			b = detail::read_u64(p + remaining - 8);
+		}
+
+		a ^= hash_secret[1];
+		b ^= seed;
+		detail::hash_multiply(a, b);
+		return hash_multiply_fold(a ^ hash_secret[0] ^ size, b ^ hash_secret[1]);
+	}
+
 	template <typename IntType>
 	constexpr std::enable_if_t<std::is_integral_v<IntType>, size_t> get_hash(IntType instance)
 	{
-		/* the hash of the integer is the integer itself */
-		return static_cast<size_t>(instance);
+		return detail::fold_hash(hash_mix(static_cast<uint64_t>(instance)));
 	}
 
 	template <typename EnumType>
 	constexpr std::enable_if_t<std::is_enum_v<EnumType>, size_t> get_hash(EnumType instance)
 	{
-		/* the hash of the integer is the integer itself */
-		return static_cast<size_t>(instance);
+		return detail::fold_hash(hash_mix(static_cast<uint64_t>(instance)));
 	}
 
 	// write any specializations needed here
 
-	constexpr size_t get_hash(const char* s)
+	inline size_t get_hash(const char* s)
 	{
-		return fnv_1a(s, crt::strlen(s));
+		return detail::fold_hash(hash_bytes(s, crt::strlen(s)));
 	}
 
 	template <typename T, typename... Rest>
@@ -71,14 +225,20 @@ namespace crt
 		if (f == 0)
 			return 0;
 
-		return *(uint32_t*)&f;
+		return detail::fold_hash(hash_mix(*(uint32_t*)&f));
+	}
+
+	template <typename T>
+	size_t get_hash(const T* pointer)
+	{
+		return detail::fold_hash(hash_mix(reinterpret_cast<uintptr_t>(pointer)));
 	}
 
+	// types that carry their own precomputed hash, like crt::atom
 	template <typename T>
-	constexpr size_t get_hash(const T* pointer)
+	auto get_hash(const T& value) -> decltype(static_cast<size_t>(value.hash()))
 	{
-		const size_t seed = (size_t)pointer;
-		return seed ^ (seed >> 16);
+		return value.hash();
 	}
 
 }
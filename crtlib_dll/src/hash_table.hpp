@@ -1,19 +1,56 @@
 #pragma once
 #include "my_memory.h"
+#include "heap_allocator.h"
 #include "hash.hpp"
 #include "maybe.hpp"
 #include "smart_ptr.hpp"
+#include "clock.h"
+#include <xmmintrin.h>
 
 namespace crt
 {
-	template <typename K, typename V>
+	constexpr size_t hash_map_histogram_size = 16;
+
+	// snapshot of the shape of a hash_map, see hash_map::stats
+	struct hash_map_stats
+	{
+		size_t size;
+		size_t capacity;
+		size_t tombstones;				// deleted slots, they lengthen every probe sequence that passes them
+		float load_factor;				// occupied slots / capacity
+		float tombstone_ratio;			// deleted slots / capacity
+		float average_probe_length;		// slots visited to find a present key, 1 if every key is in its home slot
+		size_t max_probe_length;
+		size_t probe_length_histogram[hash_map_histogram_size]; // [i] keys found after i + 1 probes, the last entry collects longer ones
+		size_t resize_count;
+		double resize_time_ms;			// total time spent rehashing in resize
+	};
+
+	// how hash_map hashes and compares its keys. a custom traits type provides the same two static functions,
+	// see case_insensitive_key_traits in string_utils.hpp
+	template <typename K>
+	struct default_key_traits
+	{
+		static constexpr size_t hash(const K& key)
+		{
+			return crt::get_hash(key);
+		}
+
+		static constexpr bool equal(const K& lhs, const K& rhs)
+		{
+			return lhs == rhs;
+		}
+	};
+
+	template <typename K, typename V, typename KeyTraits = default_key_traits<K>>
 	class hash_map
 	{
 		enum slot_state : uint8_t
 		{
 			null = 0, // unoccupied
 			deleted = 1, // deleted
-			occupied = 2 // occupied
+			occupied = 2, // occupied
+			pending = 3 // occupied, waiting to be moved by purge_tombstones
 		};
 
 		class table_slot
@@ -21,28 +58,48 @@ namespace crt
 		public:
 			// at the start of the lifetime of the slot, key_ and value_ are in uninitialized states.
 			// that is, no default constructors from type K or type V are called. 
-			table_slot() : state_(null), key_{}, value_{}
+			table_slot() : state_(null), hashcode_key_(0)
 			{
 
 			}
 
+			table_slot(const table_slot&) = delete;
+			table_slot& operator=(const table_slot&) = delete;
+
+			~table_slot()
+			{
+				if (state_ == occupied)
+					destruct_key_and_value();
+			}
+
 			const K& get_key() const
 			{
-				return key_;
+				return *reinterpret_cast<const K*>(key_);
 			}
 
 			const V& get_value() const
 			{
-				return value_;
+				return *reinterpret_cast<const V*>(value_);
 			}
 
 			V& get_value()
 			{
-				return value_;
+				return *reinterpret_cast<V*>(value_);
 			}
 
 		private:
 
+			// construct key and value in place, marking the slot as occupied
+			template <typename KeyType, typename... Args>
+			void construct(KeyType&& key, size_t key_hashcode, Args&&... value_args)
+			{
+				new(key_) K(std::forward<KeyType>(key));
+				new(value_) V(std::forward<Args>(value_args)...);
+
+				hashcode_key_ = key_hashcode;
+				state_ = occupied;
+			}
+
 			// remove the slot, destructing its key and value
 			void remove()
 			{
@@ -53,8 +110,13 @@ namespace crt
 			// explicitly call destructors for key and value
 			void destruct_key_and_value()
 			{
-				(&key_)->~K();
-				(&value_)->~V();
+				reinterpret_cast<K*>(key_)->~K();
+				reinterpret_cast<V*>(value_)->~V();
+			}
+
+			K& key()
+			{
+				return *reinterpret_cast<K*>(key_);
 			}
 
 			friend class hash_map;
@@ -65,11 +127,11 @@ namespace crt
 			// 4 bytes
 			size_t hashcode_key_; // cached hashcode of the key for fast comparison
 
-			// K bytes
-			K key_{};
+			// K bytes, only constructed while the slot is occupied
+			alignas(K) uint8_t key_[sizeof(K)];
 
-			// V bytes
-			V value_{};
+			// V bytes, only constructed while the slot is occupied
+			alignas(V) uint8_t value_[sizeof(V)];
 		};
 
 	public:
@@ -111,7 +173,7 @@ namespace crt
 
 		}
 
-		constexpr hash_map(std::initializer_list<crt::pair<K, V>> args)
+		constexpr hash_map(std::initializer_list<crt::pair<K, V>> args) : hash_map()
 		{
 			for (const auto& elem : args)
 			{
@@ -146,17 +208,22 @@ namespace crt
 		constexpr hash_map(const hash_map& other) : table_(nullptr), table_size_(0), table_capacity_(0)
 		{
 			if (other.table_capacity_)
-				resize(other.table_capacity_); // default constructor will be called for all slots
+				resize(other.table_capacity_); // all slots are null, keys/values are not constructed
 
 			/* copy slots */
 			for (size_t i = 0; i < other.table_capacity_; i++)
 			{
-				// hashcode_key and state will be copied directly
-				// the key's and value's will be deep copied, if they exist 
-				table_[i] = other.table_[i];
+				const auto& source = other.table_[i];
+
+				// keep the same layout, including tombstones, so that probe sequences stay valid
+				if (source.state_ == occupied)
+					table_[i].construct(K(source.get_key()), source.hashcode_key_, source.get_value());
+				else
+					table_[i].state_ = source.state_;
 			}
 
 			table_size_ = other.table_size_;
+			tombstone_count_ = other.tombstone_count_;
 		}
 
 		constexpr hash_map& operator=(hash_map other)
@@ -170,6 +237,9 @@ namespace crt
 			swap(lhs.table_, rhs.table_);
 			swap(lhs.table_size_, rhs.table_size_);
 			swap(lhs.table_capacity_, rhs.table_capacity_);
+			swap(lhs.tombstone_count_, rhs.tombstone_count_);
+			swap(lhs.resize_count_, rhs.resize_count_);
+			swap(lhs.resize_time_ms_, rhs.resize_time_ms_);
 		}
 
 		constexpr iterator begin() const
@@ -192,20 +262,162 @@ namespace crt
 			return iterator(end_slot, end_slot);
 		}
 
-		constexpr V& operator [](K key) {
-			return find_or_insert(move(key));
+		constexpr V& operator [](const K& key) {
+			return try_emplace(key).first()->get_value();
 		}
 
-		// insert key/value into table
+		constexpr V& operator [](K&& key) {
+			return try_emplace(crt::move(key)).first()->get_value();
+		}
+
+		// insert key/value into table, overwriting the value if the key already exists
 		constexpr table_slot* insert(K key, V value)
 		{
-			if (table_size_ == table_capacity_ || load_factor() >= 0.6f)
+			return insert_or_assign(crt::move(key), crt::move(value));
+		}
+
+		// constructs the value in place from args if the key does not exist, otherwise leaves the table untouched.
+		// returns the slot of the key and whether an insertion took place. the key is only copied or moved into
+		// the table when it is inserted, finding an existing key costs no copy.
+		template <typename... Args>
+		constexpr crt::pair<table_slot*, bool> try_emplace(const K& key, Args&&... args)
+		{
+			return try_emplace_hashed(key, KeyTraits::hash(key), std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		constexpr crt::pair<table_slot*, bool> try_emplace(K&& key, Args&&... args)
+		{
+			const auto key_hash_code = KeyTraits::hash(key);
+			return try_emplace_hashed(crt::move(key), key_hash_code, std::forward<Args>(args)...);
+		}
+
+		// try_emplace with a precomputed hash of the key
+		template <typename... Args>
+		constexpr crt::pair<table_slot*, bool> try_emplace_hashed(const K& key, size_t key_hash_code, Args&&... args)
+		{
+			return emplace_hashed(key, key_hash_code, std::forward<Args>(args)...);
+		}
+
+		template <typename... Args>
+		constexpr crt::pair<table_slot*, bool> try_emplace_hashed(K&& key, size_t key_hash_code, Args&&... args)
+		{
+			return emplace_hashed(crt::move(key), key_hash_code, std::forward<Args>(args)...);
+		}
+
+	private:
+		// KeyType is const K& or K, forwarded into the slot only on insertion
+		template <typename KeyType, typename... Args>
+		constexpr crt::pair<table_slot*, bool> emplace_hashed(KeyType&& key, size_t key_hash_code, Args&&... args)
+		{
+			auto slot = probe(key, key_hash_code);
+			if (slot && slot->state_ == occupied)
+				return crt::make_pair(slot, false);
+
+			if (!slot || table_size_ == table_capacity_ || load_factor() >= 0.6f)
 			{
+				// the key does not exist, so the position found before the resize is not needed. 
 				resize(table_capacity_ ? get_next_table_capacity() : 13);
+				slot = find_free_slot(key_hash_code, table_, table_capacity_);
 			}
 
-			auto key_hash_code = crt::get_hash(key);
-			return insert(crt::move(key), key_hash_code, crt::move(value), table_, table_capacity_, table_size_);
+			if (slot->state_ == deleted)
+				--tombstone_count_;
+
+			slot->construct(std::forward<KeyType>(key), key_hash_code, std::forward<Args>(args)...);
+			++table_size_;
+			return crt::make_pair(slot, true);
+		}
+
+	public:
+
+		// inserts key/value if the key does not exist, otherwise assigns value to the existing key.
+		constexpr table_slot* insert_or_assign(K key, V value)
+		{
+			auto result = try_emplace(crt::move(key), crt::move(value));
+			if (!result.second())
+				result.first()->get_value() = crt::move(value);
+
+			return result.first();
+		}
+
+		// applies fn(V&) to the value of the key, value initializing it first if the key does not exist.
+		// useful for counters and aggregations: upsert(key, [](auto& count) { ++count; });
+		template <typename F>
+		constexpr V& upsert(const K& key, F fn)
+		{
+			auto& value = try_emplace(key).first()->get_value();
+			fn(value);
+			return value;
+		}
+
+		template <typename F>
+		constexpr V& upsert(K&& key, F fn)
+		{
+			auto& value = try_emplace(crt::move(key)).first()->get_value();
+			fn(value);
+			return value;
+		}
+
+		// look up count keys, writing a pointer to each value (nullptr if the key does not exist) into values_out.
+		// keys are hashed in groups and their home slots are prefetched before probing,
+		// so the cache misses of a group overlap instead of being paid one after another.
+		constexpr void find_batch(const K* keys, size_t count, V** values_out)
+		{
+			size_t hashes[batch_group_size];
+
+			for (size_t group = 0; group < count; group += batch_group_size)
+			{
+				const auto group_size = count - group < batch_group_size ? count - group : batch_group_size;
+
+				prefetch_group(keys + group, group_size, hashes);
+
+				for (size_t i = 0; i < group_size; ++i)
+				{
+					const auto slot = find_slot(keys[group + i], hashes[i]);
+					values_out[group + i] = slot ? &slot->get_value() : nullptr;
+				}
+			}
+		}
+
+		// insert or assign count key/value pairs. the table is grown once up front, then the keys
+		// are hashed and prefetched in groups like find_batch.
+		constexpr void insert_batch(const K* keys, const V* values, size_t count)
+		{
+			reserve(table_size_ + count);
+
+			size_t hashes[batch_group_size];
+
+			for (size_t group = 0; group < count; group += batch_group_size)
+			{
+				const auto group_size = count - group < batch_group_size ? count - group : batch_group_size;
+
+				prefetch_group(keys + group, group_size, hashes);
+
+				for (size_t i = 0; i < group_size; ++i)
+				{
+					auto result = try_emplace_hashed(keys[group + i], hashes[i], values[group + i]);
+					if (!result.second())
+						result.first()->get_value() = values[group + i];
+				}
+			}
+		}
+
+		// grow the table so that it can hold count elements without resizing
+		constexpr void reserve(size_t count)
+		{
+			// try_emplace grows once the load factor reaches 0.6 before an insertion,
+			// so count - 1 elements must stay below 0.6 of the capacity
+			auto needed_capacity = count * 5 / 3 + 1;
+			if (needed_capacity <= table_capacity_)
+				return;
+
+			while (!is_prime(++needed_capacity))
+			{
+
+			}
+
+			resize(needed_capacity);
 		}
 
 		// find value by key  returns nullptr if the key does not exist
@@ -241,6 +453,7 @@ namespace crt
 			{
 				s->remove();
 				--table_size_;
+				++tombstone_count_;
 			}
 		}
 
@@ -257,11 +470,12 @@ namespace crt
 		// returns the value by ref if key exists, otherwise inserts it and returns the value by ref.
 		constexpr V& find_or_insert(const K& key)
 		{
-			auto slot = find_slot(key);
-			if (slot)
-				return slot->get_value();
+			return try_emplace(key).first()->get_value();
+		}
 
-			return insert(key, V{})->get_value();
+		constexpr V& find_or_insert(K&& key)
+		{
+			return try_emplace(crt::move(key)).first()->get_value();
 		}
 
 		constexpr float load_factor() const
@@ -269,6 +483,105 @@ namespace crt
 			return table_capacity_ ? (float)table_size_ / (float)table_capacity_ : 1.f;
 		}
 
+		constexpr size_t tombstone_count() const
+		{
+			return tombstone_count_;
+		}
+
+		constexpr float tombstone_ratio() const
+		{
+			return table_capacity_ ? (float)tombstone_count_ / (float)table_capacity_ : 0.f;
+		}
+
+		// walks the whole table, meant for diagnostics rather than hot paths
+		hash_map_stats stats() const
+		{
+			hash_map_stats result{};
+			result.size = table_size_;
+			result.capacity = table_capacity_;
+			result.tombstones = tombstone_count_;
+			result.load_factor = table_capacity_ ? load_factor() : 0.f;
+			result.tombstone_ratio = tombstone_ratio();
+			result.resize_count = resize_count_;
+			result.resize_time_ms = resize_time_ms_;
+
+			size_t total_probes = 0;
+			for (size_t i = 0; i < table_capacity_; ++i)
+			{
+				const auto& slot = table_[i];
+				if (slot.state_ != occupied)
+					continue;
+
+				// replay the probe sequence of the key until it reaches the slot
+				size_t probes = 1;
+				while (&table_[calculate_position(slot.hashcode_key_, probes - 1, table_capacity_)] != &slot)
+					++probes;
+
+				total_probes += probes;
+				if (probes > result.max_probe_length)
+					result.max_probe_length = probes;
+
+				++result.probe_length_histogram[probes < hash_map_histogram_size ? probes - 1 : hash_map_histogram_size - 1];
+			}
+
+			result.average_probe_length = table_size_ ? (float)total_probes / (float)table_size_ : 0.f;
+			return result;
+		}
+
+		// turn all tombstones back into empty slots and move every key to the earliest free slot of its probe sequence,
+		// without allocating. use when tombstone_ratio() grows under churn, e.g. remove/insert cycles that never trigger a resize.
+		void purge_tombstones()
+		{
+			if (!tombstone_count_)
+				return;
+
+			// tombstones become empty, keys become pending and are placed one by one
+			for (size_t i = 0; i < table_capacity_; ++i)
+			{
+				auto& slot = table_[i];
+				if (slot.state_ == deleted)
+					slot.state_ = null;
+				else if (slot.state_ == occupied)
+					slot.state_ = pending;
+			}
+
+			for (size_t i = 0; i < table_capacity_; ++i)
+			{
+				auto& slot = table_[i];
+				while (slot.state_ == pending)
+				{
+					// first slot of the sequence that is not final yet. every slot before it holds a placed key,
+					// so lookups reach the target without crossing an empty slot.
+					table_slot* target = nullptr;
+					for (size_t probe_index = 0; probe_index < table_capacity_ && !target; ++probe_index)
+					{
+						auto& candidate = table_[calculate_position(slot.hashcode_key_, probe_index, table_capacity_)];
+						if (candidate.state_ != occupied)
+							target = &candidate;
+					}
+
+					if (target == &slot)
+					{
+						slot.state_ = occupied;
+					}
+					else if (target->state_ == null)
+					{
+						target->construct(crt::move(slot.key()), slot.hashcode_key_, crt::move(slot.get_value()));
+						slot.destruct_key_and_value();
+						slot.state_ = null;
+					}
+					else
+					{
+						// the target holds another pending key, exchange them and continue placing that one from here
+						swap_contents(slot, *target);
+						slot.state_ = pending;
+					}
+				}
+			}
+
+			tombstone_count_ = 0;
+		}
+
 		constexpr crt::maybe<V> find_value(const K& key) const
 		{
 			const auto slot = find_slot(key);
@@ -280,7 +593,12 @@ namespace crt
 		// find slot by key, returns nullptr if slot does not exist
 		constexpr table_slot* find_slot(const K& key) const
 		{
-			auto key_code = crt::get_hash(key);
+			return find_slot(key, KeyTraits::hash(key));
+		}
+
+		// find slot by key and its precomputed hash, returns nullptr if slot does not exist
+		constexpr table_slot* find_slot(const K& key, size_t key_code) const
+		{
 			for (size_t probe_index = 0; probe_index < table_capacity_; ++probe_index)
 			{
 				const auto pos = calculate_position(key_code, probe_index, table_capacity_);
@@ -295,7 +613,7 @@ namespace crt
 
 				const auto& table_key = table_[pos].get_key();
 
-				if (table_[pos].hashcode_key_ == key_code && table_key == key)
+				if (table_[pos].hashcode_key_ == key_code && KeyTraits::equal(table_key, key))
 				{
 					return &table_[pos];
 				}
@@ -310,63 +628,105 @@ namespace crt
 		/* resize the table. this requires re-hashing of the entire table as the hash functions will change */
 		constexpr void resize(size_t new_capacity)
 		{
+			const auto start = clock::now();
+
 			// this does not invoke the default constructor of keys or values
 			// invokes default constructor for all slots -> key/value are not constructed yet, all slots are null.
 			table_slot* new_table = new table_slot[new_capacity];
 			size_t new_size = 0;
 
-			/* insert all occupied positions in the current table to the new table */
+			/* move all occupied positions in the current table to the new table */
 			for (size_t i = 0; i < table_capacity_; i++)
 			{
 				auto& slot = table_[i];
 				if (slot.state_ == occupied)
 				{
-					// use slot.hashcode_key instead of recalculating it. just calculate the new position.
-					K key = crt::move(slot.get_key());
-					V value = crt::move(slot.get_value());
+					// keys are unique, so just find a free position by using slot.hashcode_key instead of recalculating it.
+					find_free_slot(slot.hashcode_key_, new_table, new_capacity)->construct(
+						crt::move(slot.key()), slot.hashcode_key_, crt::move(slot.get_value()));
 
-					/* insert the key-value pair into the new table */
-					insert(crt::move(key), slot.hashcode_key_, crt::move(value), new_table, new_capacity, new_size);
+					++new_size;
 				}
 			}
 
-			// invokes the destructor for all of the slots, which then invokes destructors for key/values.
+			// invokes the destructor for all of the slots, which then invokes destructors for moved-from key/values.
 			if (table_)
 				delete[] table_;
 
 			table_ = new_table;
 			table_size_ = new_size; // assert(table_size_ == new_size)
 			table_capacity_ = new_capacity;
+			tombstone_count_ = 0;
+
+			++resize_count_;
+			resize_time_ms_ += clock::now().difference_ms(start);
 		}
 
-		constexpr static table_slot* insert(K key, size_t key_hashcode, V value, table_slot* table, size_t table_capacity, size_t& table_size)
+		// single pass over the probe sequence of the key. returns the slot containing the key if it exists,
+		// otherwise the first reusable (deleted or null) slot in the sequence. returns nullptr if neither exists.
+		constexpr table_slot* probe(const K& key, size_t key_hashcode) const
 		{
-			for (size_t probe_index = 0; probe_index < table_capacity; ++probe_index)
+			table_slot* first_free = nullptr;
+
+			for (size_t probe_index = 0; probe_index < table_capacity_; ++probe_index)
 			{
-				auto pos = calculate_position(key_hashcode, probe_index, table_capacity);
-				if (table[pos].state_ == null || table[pos].state_ == deleted)
-				{
-					// we construct the object by using the move constructor at the given location
-					table[pos].state_ = occupied;
-					table[pos].hashcode_key_ = key_hashcode;
+				auto& slot = table_[calculate_position(key_hashcode, probe_index, table_capacity_)];
 
-					// invoke move constructors for key and value
-					table[pos].key_ = crt::move(key);
-					table[pos].value_ = crt::move(value);
+				/* search ended, the key does not exist */
+				if (slot.state_ == null)
+					return first_free ? first_free : &slot;
 
-					++table_size;
-					return &table[pos];
+				/* remember the first tombstone, but keep searching as the key may be further in the sequence */
+				if (slot.state_ == deleted)
+				{
+					if (!first_free)
+						first_free = &slot;
+					continue;
 				}
 
-				/* the slot is occupied, check if the key is same, if so, overwrite the slot's value */
-				const K& table_key = table[pos].get_key();
-				if (table[pos].hashcode_key_ == key_hashcode && table_key == key)
+				if (slot.hashcode_key_ == key_hashcode && KeyTraits::equal(slot.get_key(), key))
+					return &slot;
+			}
+
+			return first_free;
+		}
+
+		// hash a group of keys and prefetch their home slots
+		constexpr void prefetch_group(const K* keys, size_t count, size_t* hashes_out) const
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				hashes_out[i] = KeyTraits::hash(keys[i]);
+
+				if (table_capacity_)
 				{
-					// place the new value. construct_object will automatically call the destructor for the previous object.
-					table[pos].value_ = crt::move(value);
-					return &table[pos];
+					const auto home = &table_[calculate_position(hashes_out[i], 0, table_capacity_)];
+					_mm_prefetch(reinterpret_cast<const char*>(home), _MM_HINT_T0);
 				}
 			}
+		}
+
+		// exchange keys, values and hashes of two constructed slots
+		static void swap_contents(table_slot& a, table_slot& b)
+		{
+			K key(crt::move(a.key()));
+			V value(crt::move(a.get_value()));
+			const auto hashcode = a.hashcode_key_;
+			a.destruct_key_and_value();
+			a.construct(crt::move(b.key()), b.hashcode_key_, crt::move(b.get_value()));
+			b.destruct_key_and_value();
+			b.construct(crt::move(key), hashcode, crt::move(value));
+		}
+
+		// find first null or deleted slot in the probe sequence of the hashcode
+		constexpr static table_slot* find_free_slot(size_t key_hashcode, table_slot* table, size_t table_capacity)
+		{
+			for (size_t probe_index = 0; probe_index < table_capacity; ++probe_index)
+			{
+				auto& slot = table[calculate_position(key_hashcode, probe_index, table_capacity)];
+				if (slot.state_ != occupied)
+					return &slot;
+			}
 
 			// should not happen
 			return nullptr;
@@ -425,8 +785,14 @@ namespace crt
 		}
 
 
+		// number of keys hashed and prefetched ahead of probing in the batch functions
+		constexpr static size_t batch_group_size = 16;
+
 		table_slot* table_;
 		size_t table_size_;
 		size_t table_capacity_;
+		size_t tombstone_count_{};
+		size_t resize_count_{};
+		double resize_time_ms_{};
 	};
 }
@@ -0,0 +1,403 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+
+#include "assert.h"
+#include "hash.hpp"
+#include "maybe.hpp"
+#include "my_memory.h"
+#include "my_vector.hpp"
+#include "pair.hpp"
+
+namespace crt
+{
+	// hash map that keeps its entries densely in a vector, in insertion order, while the hash table only stores
+	// indexes into that vector. iteration is a contiguous walk over size() entries regardless of how many keys
+	// were removed, and the order is deterministic. the table uses linear probing with backward shift deletion,
+	// so removals never leave tombstones behind.
+	//
+	// swap_remove is O(1) but moves the last entry into the hole, shift_remove keeps the order and is O(n).
+	// pointers and iterators are invalidated by insertions and removals.
+	template <typename K, typename V>
+	class index_map
+	{
+		constexpr static uint32_t empty_slot = 0xFFFFFFFF;
+
+		struct entry
+		{
+			K key;
+			V value;
+			size_t hash;
+		};
+
+		// the hash is kept next to the index so mismatching keys are rejected without touching the entries
+		struct index_slot
+		{
+			uint32_t index;
+			uint32_t hash;
+		};
+
+		template <typename ValuePointer, typename EntryPointer>
+		struct iterator_base
+		{
+			constexpr static auto tag()
+			{
+				return random_iterator_tag{};
+			}
+
+			iterator_base(EntryPointer e) : entry_(e) {}
+
+			crt::pair<const K*, ValuePointer> operator*() const
+			{
+				return crt::make_pair(static_cast<const K*>(&entry_->key), static_cast<ValuePointer>(&entry_->value));
+			}
+
+			const K& key() const { return entry_->key; }
+			auto& value() const { return entry_->value; }
+
+			iterator_base& operator--() { --entry_; return *this; }
+			iterator_base operator--(int) { iterator_base tmp = *this; --(*this); return tmp; }
+
+			iterator_base& operator++() { ++entry_; return *this; }
+			iterator_base operator++(int) { iterator_base tmp = *this; ++(*this); return tmp; }
+
+			friend iterator_base operator- (const iterator_base& a, size_t distance) { return iterator_base(a.entry_ - distance); }
+			friend iterator_base operator+ (const iterator_base& a, size_t distance) { return iterator_base(a.entry_ + distance); }
+			friend size_t operator- (const iterator_base& a, const iterator_base& b) { return a.entry_ - b.entry_; }
+			friend bool operator== (const iterator_base& a, const iterator_base& b) { return a.entry_ == b.entry_; }
+			friend bool operator!= (const iterator_base& a, const iterator_base& b) { return a.entry_ != b.entry_; }
+
+		private:
+			EntryPointer entry_;
+		};
+
+	public:
+		using iterator = iterator_base<V*, entry*>;
+		using const_iterator = iterator_base<const V*, const entry*>;
+
+		index_map() = default;
+
+		index_map(std::initializer_list<crt::pair<K, V>> args)
+		{
+			reserve(args.size());
+			for (const auto& elem : args)
+				insert(elem.first(), elem.second());
+		}
+
+		explicit index_map(size_t initial_capacity)
+		{
+			reserve(initial_capacity);
+		}
+
+		// insert key/value, overwriting the value if the key already exists. a new key is appended at the end of the order.
+		// the key is only copied or moved into the map when it is new.
+		V& insert(const K& key, V value)
+		{
+			return insert_imp(key, crt::move(value));
+		}
+
+		V& insert(K&& key, V value)
+		{
+			return insert_imp(crt::move(key), crt::move(value));
+		}
+
+		// returns the value by ref if key exists, otherwise appends it with a default value and returns the value by ref.
+		V& find_or_insert(const K& key)
+		{
+			return find_or_insert_imp(key);
+		}
+
+		V& find_or_insert(K&& key)
+		{
+			return find_or_insert_imp(crt::move(key));
+		}
+
+		V& operator[](const K& key)
+		{
+			return find_or_insert_imp(key);
+		}
+
+		V& operator[](K&& key)
+		{
+			return find_or_insert_imp(crt::move(key));
+		}
+
+		crt::maybe<V> find_value(const K& key) const
+		{
+			const auto index = find_index(key, crt::get_hash(key));
+			if (index == empty_slot)
+				return crt::nothing<V>();
+
+			return crt::just(entries_[index].value);
+		}
+
+		// returns nullptr if the key does not exist
+		V* find(const K& key)
+		{
+			const auto index = find_index(key, crt::get_hash(key));
+			return index != empty_slot ? &entries_[index].value : nullptr;
+		}
+
+		const V* find(const K& key) const
+		{
+			const auto index = find_index(key, crt::get_hash(key));
+			return index != empty_slot ? &entries_[index].value : nullptr;
+		}
+
+		// position of key in the insertion order
+		crt::maybe<size_t> index_of(const K& key) const
+		{
+			const auto index = find_index(key, crt::get_hash(key));
+			if (index == empty_slot)
+				return crt::nothing<size_t>();
+
+			return crt::just(static_cast<size_t>(index));
+		}
+
+		bool contains(const K& key) const
+		{
+			return find_index(key, crt::get_hash(key)) != empty_slot;
+		}
+
+		// remove key by moving the last entry into its place. O(1), changes the position of the last entry.
+		bool swap_remove(const K& key)
+		{
+			const auto slot = find_slot_position(key, crt::get_hash(key));
+			if (slot == npos)
+				return false;
+
+			const auto index = slots_[slot].index;
+			erase_slot(slot);
+
+			const auto last = static_cast<uint32_t>(entries_.size() - 1);
+			if (index != last)
+			{
+				slots_[slot_of_index(last, entries_[last].hash)].index = index;
+				entries_[index] = crt::move(entries_[last]);
+			}
+
+			entries_.pop_back();
+			return true;
+		}
+
+		// remove key and shift the following entries down, keeping the insertion order. O(n)
+		bool shift_remove(const K& key)
+		{
+			const auto slot = find_slot_position(key, crt::get_hash(key));
+			if (slot == npos)
+				return false;
+
+			const auto index = slots_[slot].index;
+			erase_slot(slot);
+
+			for (auto& s : slots_)
+			{
+				if (s.index != empty_slot && s.index > index)
+					--s.index;
+			}
+
+			entries_.erase_idx(index);
+			return true;
+		}
+
+		// remove and return the most recently inserted entry
+		crt::pair<K, V> pop()
+		{
+			CRT_ASSERT(!entries_.empty(), "pop on empty index_map!");
+
+			const auto last = static_cast<uint32_t>(entries_.size() - 1);
+			erase_slot(slot_of_index(last, entries_[last].hash));
+
+			auto& e = entries_[last];
+			auto result = crt::make_pair(crt::move(e.key), crt::move(e.value));
+			entries_.pop_back();
+			return result;
+		}
+
+		// entry at position index of the insertion order
+		crt::pair<const K*, V*> at(size_t index)
+		{
+			CRT_ASSERT(index < entries_.size(), "index_map out of bounds access!");
+			return crt::make_pair(static_cast<const K*>(&entries_[index].key), &entries_[index].value);
+		}
+
+		void reserve(size_t capacity)
+		{
+			entries_.reserve(capacity);
+
+			size_t needed_slots = 8;
+			while (needed_slots * 3 < capacity * 4)
+				needed_slots <<= 1;
+
+			if (needed_slots > slots_.size())
+				rebuild_table(needed_slots);
+		}
+
+		void clear()
+		{
+			entries_.erase();
+			for (auto& s : slots_)
+				s.index = empty_slot;
+		}
+
+		// in insertion order
+		iterator begin() { return iterator(entries_.data()); }
+		iterator end() { return iterator(entries_.data() + entries_.size()); }
+		const_iterator begin() const { return const_iterator(entries_.data()); }
+		const_iterator end() const { return const_iterator(entries_.data() + entries_.size()); }
+
+		size_t size() const
+		{
+			return entries_.size();
+		}
+
+		bool empty() const
+		{
+			return entries_.empty();
+		}
+
+		float load_factor() const
+		{
+			return slots_.empty() ? 1.f : (float)entries_.size() / (float)slots_.size();
+		}
+
+	private:
+		// KeyType is const K& or K
+		template <typename KeyType>
+		V& insert_imp(KeyType&& key, V&& value)
+		{
+			const auto hash = crt::get_hash(key);
+			const auto existing = find_index(key, hash);
+			if (existing != empty_slot)
+			{
+				auto& result = entries_[existing].value;
+				result = crt::move(value);
+				return result;
+			}
+
+			return append(std::forward<KeyType>(key), crt::move(value), hash);
+		}
+
+		template <typename KeyType>
+		V& find_or_insert_imp(KeyType&& key)
+		{
+			const auto hash = crt::get_hash(key);
+			const auto existing = find_index(key, hash);
+			if (existing != empty_slot)
+				return entries_[existing].value;
+
+			return append(std::forward<KeyType>(key), V{}, hash);
+		}
+
+		// the entry is built with its value, it is never default constructed and then assigned
+		template <typename KeyType>
+		V& append(KeyType&& key, V&& value, size_t hash)
+		{
+			if ((entries_.size() + 1) * 4 > slots_.size() * 3)
+				grow_table();
+
+			const auto index = static_cast<uint32_t>(entries_.size());
+			place(index, hash);
+			entries_.push_back(entry{ std::forward<KeyType>(key), crt::move(value), hash });
+			return entries_.back().value;
+		}
+
+		constexpr static size_t npos = ~size_t(0);
+
+		static uint32_t short_hash(size_t hash)
+		{
+			return static_cast<uint32_t>(hash);
+		}
+
+		size_t home_of(size_t hash) const
+		{
+			return hash & (slots_.size() - 1);
+		}
+
+		// table position of key, or npos
+		size_t find_slot_position(const K& key, size_t hash) const
+		{
+			if (slots_.empty())
+				return npos;
+
+			const auto mask = slots_.size() - 1;
+			for (auto position = home_of(hash);; position = (position + 1) & mask)
+			{
+				const auto& s = slots_[position];
+				if (s.index == empty_slot)
+					return npos;
+
+				if (s.hash == short_hash(hash) && entries_[s.index].key == key)
+					return position;
+			}
+		}
+
+		uint32_t find_index(const K& key, size_t hash) const
+		{
+			const auto position = find_slot_position(key, hash);
+			return position != npos ? slots_[position].index : empty_slot;
+		}
+
+		// table position that refers to the entry at index
+		size_t slot_of_index(uint32_t index, size_t hash) const
+		{
+			const auto mask = slots_.size() - 1;
+			auto position = home_of(hash);
+			while (slots_[position].index != index)
+				position = (position + 1) & mask;
+
+			return position;
+		}
+
+		void place(uint32_t index, size_t hash)
+		{
+			const auto mask = slots_.size() - 1;
+			auto position = home_of(hash);
+			while (slots_[position].index != empty_slot)
+				position = (position + 1) & mask;
+
+			slots_[position] = index_slot{ index, short_hash(hash) };
+		}
+
+		// backward shift deletion: pull following entries of the cluster back into the hole
+		// unless that would move them before their home position
+		void erase_slot(size_t position)
+		{
+			const auto mask = slots_.size() - 1;
+			auto hole = position;
+			auto next = (hole + 1) & mask;
+
+			while (slots_[next].index != empty_slot)
+			{
+				const auto home = home_of(entries_[slots_[next].index].hash);
+
+				// distance from home to next is at least the distance from home to hole, the entry may move back
+				if (((next - home) & mask) >= ((next - hole) & mask))
+				{
+					slots_[hole] = slots_[next];
+					hole = next;
+				}
+
+				next = (next + 1) & mask;
+			}
+
+			slots_[hole].index = empty_slot;
+		}
+
+		void grow_table()
+		{
+			rebuild_table(slots_.empty() ? 8 : slots_.size() * 2);
+		}
+
+		void rebuild_table(size_t slot_count)
+		{
+			slots_ = vector<index_slot>(slot_count, index_slot{ empty_slot, 0 });
+
+			for (uint32_t i = 0; i < entries_.size(); ++i)
+				place(i, entries_[i].hash);
+		}
+
+		vector<entry> entries_{};
+		vector<index_slot> slots_{};
+	};
+}
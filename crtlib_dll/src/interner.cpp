@@ -0,0 +1,174 @@
+#include "interner.hpp"
+
+namespace crt
+{
+	constexpr size_t interner_block_size = 64 * 1024;
+
+	// strings larger than this get a block of their own instead of wasting the rest of the current block
+	constexpr size_t interner_large_entry = interner_block_size / 4;
+
+	constexpr size_t interner_initial_slots = 64;
+
+	static string_interner g_interner;
+
+	string_interner& global_interner()
+	{
+		return g_interner;
+	}
+
+	string_interner::~string_interner()
+	{
+		for (auto& s : shards_)
+		{
+			for (auto block : s.blocks)
+				free(block);
+		}
+	}
+
+	atom string_interner::intern(const char* str, size_t size)
+	{
+		if (!size)
+			return atom();
+
+		const auto hash = get_string_hash(str, size);
+		auto& s = shard_of(hash);
+		lock_guard guard{ s.lock };
+
+		if (const auto entry = lookup(s, str, size, hash))
+			return atom(entry);
+
+		// keep the load factor at or below 3/4
+		if ((s.count + 1) * 4 > s.table.size() * 3)
+			grow(s);
+
+		const auto entry = store(s, str, size, hash);
+		place(s.table, entry);
+		++s.count;
+		return atom(entry);
+	}
+
+	maybe<atom> string_interner::find(const char* str, size_t size)
+	{
+		if (!size)
+			return just(atom());
+
+		const auto hash = get_string_hash(str, size);
+		auto& s = shard_of(hash);
+		lock_guard guard{ s.lock };
+
+		if (const auto entry = lookup(s, str, size, hash))
+			return just(atom(entry));
+
+		return nothing<atom>();
+	}
+
+	size_t string_interner::size()
+	{
+		size_t total = 0;
+		for (auto& s : shards_)
+		{
+			lock_guard guard{ s.lock };
+			total += s.count;
+		}
+
+		return total;
+	}
+
+	size_t string_interner::memory_usage()
+	{
+		size_t total = 0;
+		for (auto& s : shards_)
+		{
+			lock_guard guard{ s.lock };
+			total += s.arena_bytes + s.table.size() * sizeof(const detail::atom_entry*);
+		}
+
+		return total;
+	}
+
+	string_interner::shard& string_interner::shard_of(size_t hash)
+	{
+		// the table slot uses the low bits, the shard the top ones
+		return shards_[hash >> (sizeof(size_t) * 8 - 4)];
+	}
+
+	const detail::atom_entry* string_interner::lookup(const shard& s, const char* str, size_t size, size_t hash)
+	{
+		if (s.table.empty())
+			return nullptr;
+
+		const auto mask = s.table.size() - 1;
+		for (auto position = hash & mask; ; position = (position + 1) & mask)
+		{
+			const auto entry = s.table[position];
+			if (!entry)
+				return nullptr;
+
+			if (entry->hash == hash && entry->size == size && detail::equal_imp(entry->c_str(), str, size))
+				return entry;
+		}
+	}
+
+	const detail::atom_entry* string_interner::store(shard& s, const char* str, size_t size, size_t hash)
+	{
+		// header, characters and null terminator, rounded up so the next header stays aligned
+		constexpr auto alignment = alignof(detail::atom_entry);
+		const auto bytes = (sizeof(detail::atom_entry) + size + 1 + alignment - 1) & ~(alignment - 1);
+
+		uint8_t* memory;
+		if (bytes > interner_large_entry)
+		{
+			memory = static_cast<uint8_t*>(alloc(bytes));
+			s.blocks.push_back(memory);
+			s.arena_bytes += bytes;
+		}
+		else
+		{
+			if (bytes > s.remaining)
+			{
+				s.cursor = static_cast<uint8_t*>(alloc(interner_block_size));
+				s.remaining = interner_block_size;
+				s.blocks.push_back(s.cursor);
+				s.arena_bytes += interner_block_size;
+			}
+
+			memory = s.cursor;
+			s.cursor += bytes;
+			s.remaining -= bytes;
+		}
+
+		const auto entry = reinterpret_cast<detail::atom_entry*>(memory);
+		entry->hash = hash;
+		entry->size = size;
+
+		const auto text = reinterpret_cast<char*>(entry + 1);
+		memcpy(text, str, size);
+		text[size] = 0;
+
+		return entry;
+	}
+
+	void string_interner::place(vector<const detail::atom_entry*>& table, const detail::atom_entry* entry)
+	{
+		const auto mask = table.size() - 1;
+		auto position = entry->hash & mask;
+		while (table[position])
+			position = (position + 1) & mask;
+
+		table[position] = entry;
+	}
+
+	void string_interner::grow(shard& s)
+	{
+		const auto slot_count = s.table.empty() ? interner_initial_slots : s.table.size() * 2;
+		vector<const detail::atom_entry*> table(slot_count, nullptr);
+
+		for (const auto entry : s.table)
+		{
+			if (entry)
+				place(table, entry);
+		}
+
+		s.table = crt::move(table);
+	}
+}
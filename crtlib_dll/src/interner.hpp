@@ -0,0 +1,161 @@
+#pragma once
+#include <cstdint>
+
+#include "hash.hpp"
+#include "maybe.hpp"
+#include "mutex.h"
+#include "my_string.hpp"
+#include "my_vector.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		// header in front of the characters of every interned string, both live in the arena of the interner
+		struct atom_entry
+		{
+			size_t hash;
+			size_t size;
+
+			const char* c_str() const
+			{
+				return reinterpret_cast<const char*>(this + 1);
+			}
+		};
+	}
+
+	// handle to a string stored once in a string_interner. two atoms of the same interner are equal exactly
+	// when their strings are equal, so comparing is a pointer compare and the hash is computed once when interning.
+	// an atom is valid for the lifetime of its interner. the default atom is the empty string.
+	class atom
+	{
+	public:
+		constexpr atom() = default;
+
+		const char* c_str() const
+		{
+			return entry_ ? entry_->c_str() : "";
+		}
+
+		size_t size() const
+		{
+			return entry_ ? entry_->size : 0;
+		}
+
+		bool empty() const
+		{
+			return !entry_;
+		}
+
+		// same as the hash of the string. crt::get_hash picks it up, so atoms are hash_map and set keys
+		// that are never rehashed
+		size_t hash() const
+		{
+			return entry_ ? entry_->hash : 0;
+		}
+
+		string to_string() const
+		{
+			return string(c_str(), size());
+		}
+
+		friend bool operator==(atom lhs, atom rhs)
+		{
+			return lhs.entry_ == rhs.entry_;
+		}
+
+		friend bool operator!=(atom lhs, atom rhs)
+		{
+			return lhs.entry_ != rhs.entry_;
+		}
+
+		// orders by address, stable while the interner lives but not lexicographical
+		friend bool operator<(atom lhs, atom rhs)
+		{
+			return lhs.entry_ < rhs.entry_;
+		}
+
+	private:
+		friend class string_interner;
+
+		explicit atom(const detail::atom_entry* entry) : entry_(entry) {}
+
+		const detail::atom_entry* entry_{};
+	};
+
+	// stores every distinct string once and hands out atoms for them.
+	// strings are copied into arena blocks that are only released by the destructor, so atoms never move.
+	// interning is thread safe: the table is split into shards that are locked independently, the shard is
+	// picked by the top bits of the hash and the slot by the low bits.
+	class string_interner
+	{
+	public:
+		string_interner() = default;
+		string_interner(const string_interner&) = delete;
+		string_interner& operator=(const string_interner&) = delete;
+		~string_interner();
+
+		// returns the atom of the string, adding it if this is the first time it is seen
+		atom intern(const char* str, size_t size);
+
+		atom intern(const char* str)
+		{
+			return intern(str, strlen(str));
+		}
+
+		atom intern(const string& str)
+		{
+			return intern(str.c_str(), str.size());
+		}
+
+		// returns the atom only if the string was interned before
+		maybe<atom> find(const char* str, size_t size);
+
+		maybe<atom> find(const string& str)
+		{
+			return find(str.c_str(), str.size());
+		}
+
+		// number of distinct strings
+		size_t size();
+
+		// bytes held by the arenas and tables
+		size_t memory_usage();
+
+	private:
+		constexpr static size_t shard_count = 16;
+
+		struct shard
+		{
+			mutex lock;
+			vector<const detail::atom_entry*> table;	// power of two size, nullptr marks an empty slot
+			size_t count{};
+			vector<uint8_t*> blocks;
+			uint8_t* cursor{};
+			size_t remaining{};
+			size_t arena_bytes{};
+		};
+
+		shard& shard_of(size_t hash);
+		static const detail::atom_entry* lookup(const shard& s, const char* str, size_t size, size_t hash);
+		static const detail::atom_entry* store(shard& s, const char* str, size_t size, size_t hash);
+		static void place(vector<const detail::atom_entry*>& table, const detail::atom_entry* entry);
+		static void grow(shard& s);
+
+		shard shards_[shard_count]{};
+	};
+
+	// interner shared by the whole module
+	string_interner& global_interner();
+
+	// intern into the global interner
+	inline atom intern(const char* str)
+	{
+		return global_interner().intern(str);
+	}
+
+	inline atom intern(const string& str)
+	{
+		return global_interner().intern(str);
+	}
+}
@@ -5,19 +5,19 @@
 namespace crt
 {
 	template <typename T>
-	T&& move(T& val)
+	constexpr T&& move(T& val)
 	{
-		return reinterpret_cast<T&&>(val);
+		return static_cast<T&&>(val);
 	}
 
 	template <typename T>
-	T&& move(T&& val)
+	constexpr T&& move(T&& val)
 	{
-		return reinterpret_cast<T&&>(val);
+		return static_cast<T&&>(val);
 	}
 
 	template <typename T>
-	void swap(T& lhs, T& rhs) noexcept
+	constexpr void swap(T& lhs, T& rhs) noexcept
 	{
 		T temp = move(lhs);
 		lhs = move(rhs);
@@ -12,8 +12,9 @@
 namespace crt
 {
 	
-	// strings less than 16 characters will not be heap allocated
-	constexpr size_t max_small_string_size = 15;
+	// every base_string is 24 bytes. strings up to base_string::max_small_size characters are stored inline,
+	// 23 for char and 11 for wchar_t, longer ones on the heap.
+	constexpr size_t string_representation_size = 24;
 
 	template <typename CharType>
 	class base_string
@@ -98,7 +99,10 @@ namespace crt
 			const CharType* ptr_;
 		};
 
-		constexpr base_string() = default;
+		constexpr base_string()
+		{
+			set_small_size(0);
+		}
 
 		/* from null terminated c string */
 		constexpr base_string(const CharType* p_null_terminated_str)
@@ -115,43 +119,27 @@ namespace crt
 
 		constexpr void assign(const CharType* p_str, size_t size)
 		{
-			if (size <= max_small_string_size)
+			if (size > capacity())
 			{
-				// use the internal buffer
-				memcpy(small_buffer_.data(), p_str, size * sizeof(CharType));
-				small_buffer_[size] = 0;
-				size_ = size;
-				capacity_ = max_small_string_size + 1;
-				buffer_ = nullptr;	// prevent double free
-			}
-			else
-			{
-				size_ = size;
-				capacity_ = (size_t)next_power_of_2(static_cast<unsigned long>(size + 1));
-				buffer_ = static_cast<CharType*>(alloc(capacity_ * sizeof(CharType)));
-				memcpy(buffer_, p_str, size * sizeof(CharType));
-				buffer_[size] = 0;
+				// the old contents are replaced, allocate the exact size instead of growing
+				release();
+				set_heap(static_cast<CharType*>(alloc((size + 1) * sizeof(CharType))), size, size);
 			}
+
+			memmove(c_str(), p_str, size * sizeof(CharType));
+			set_size(size);
 		}
 
 		/* crate a string that contains size repetitions of character.*/
-		constexpr base_string(size_t size, CharType character) : size_(size), capacity_(size + 1)
+		constexpr base_string(size_t size, CharType character) : base_string()
 		{
-			if (size <= max_small_string_size)
-			{
-				// use the internal buffer
-				for (size_t i = 0; i < size_; ++i)
-					small_buffer_[i] = character;
-				small_buffer_[size] = 0;
-				capacity_ = max_small_string_size + 1;
-			}
-			else
-			{
-				buffer_ = static_cast<CharType*>(alloc(capacity_ * sizeof(CharType)));
-				for (size_t i = 0; i < size_; ++i)
-					buffer_[i] = character;
-				buffer_[size] = 0;
-			}
+			reserve(size);
+
+			const auto data = c_str();
+			for (size_t i = 0; i < size; ++i)
+				data[i] = character;
+
+			set_size(size);
 		}
 
 		// copy constructor
@@ -164,35 +152,28 @@ namespace crt
 		constexpr base_string& operator=(const base_string& rhs)
 		{
 			if (this != &rhs)
-			{
-				free(buffer_);
 				assign(rhs.c_str(), rhs.size());
-			}
+
 			return *this;
 		}
 
 		// move constructor
-		constexpr base_string(base_string&& rhs) noexcept : base_string()
+		constexpr base_string(base_string&& rhs) noexcept
 		{
-			crt::swap(buffer_, rhs.buffer_);
-			crt::swap(size_, rhs.size_);
-			crt::swap(capacity_, rhs.capacity_);
-			crt::swap(small_buffer_, rhs.small_buffer_);
+			// the representation is position independent, heap strings move their pointer, small strings their characters
+			memcpy(bytes_, rhs.bytes_, sizeof(bytes_));
+			rhs.set_small_size(0);
 		}
 
 		// move assignment operator
 		constexpr base_string& operator=(base_string&& rhs) noexcept
 		{
-			free(buffer_);
-			buffer_ = nullptr;
-			size_ = 0;
-			capacity_ = 0;
-			// todo not resetting small_buffer_, is problem?
-
-			crt::swap(buffer_, rhs.buffer_);
-			crt::swap(size_, rhs.size_);
-			crt::swap(capacity_, rhs.capacity_);
-			crt::swap(small_buffer_, rhs.small_buffer_);
+			if (this != &rhs)
+			{
+				release();
+				memcpy(bytes_, rhs.bytes_, sizeof(bytes_));
+				rhs.set_small_size(0);
+			}
 
 			return *this;
 		}
@@ -200,12 +181,7 @@ namespace crt
 		// destructor
 		~base_string()
 		{
-			if (buffer_)
-			{
-				free(buffer_);
-				buffer_ = nullptr;
-			}
-
+			release();
 		}
 
 		constexpr const CharType& operator[](size_t index) const
@@ -234,17 +210,18 @@ namespace crt
 
 		constexpr iterator end()
 		{
-			return iterator(c_str() + size_);
+			return iterator(c_str() + size());
 		}
 
 		constexpr const_iterator end() const
 		{
-			return const_iterator(c_str() + size_);
+			return const_iterator(c_str() + size());
 		}
 
 		constexpr friend bool operator==(const base_string& s1, const base_string& s2)
 		{
-			return !detail::strcmp_imp<CharType>(s1.c_str(), s2.c_str());
+			// the sizes are known, strings of different length never have to be scanned
+			return s1.size() == s2.size() && detail::equal_imp(s1.c_str(), s2.c_str(), s1.size());
 		}
 
 		constexpr friend bool operator==(const base_string& s1, const CharType* s2)
@@ -257,56 +234,57 @@ namespace crt
 			return s2 == s1;
 		}
 
-		constexpr void reserve(size_t new_capacity)
+		// lexicographical order, used by the ordered containers. sized like operator==, so strings that differ
+		// only after an embedded null are ordered too
+		constexpr friend bool operator<(const base_string& s1, const base_string& s2)
 		{
-			if (capacity_ < new_capacity)
-			{
-				capacity_ = new_capacity;
-				buffer_ = buffer_ ? static_cast<CharType*>(realloc(buffer_, capacity_ * sizeof(CharType)))
-					: static_cast<CharType*>(alloc(capacity_ * sizeof(CharType)));
-			}
+			return detail::compare_imp<CharType>(s1.c_str(), s1.size(), s2.c_str(), s2.size()) < 0;
 		}
 
-		constexpr void resize(size_t new_size)
+		// make room for at least new_capacity characters, not counting the null terminator
+		constexpr void reserve(size_t new_capacity)
 		{
+			if (new_capacity <= capacity())
+				return;
+
 			const auto old_size = size();
-			size_ = new_size;
+			const auto bytes = (new_capacity + 1) * sizeof(CharType);
 
-			if (new_size < old_size)
+			if (is_small())
 			{
-				// shrink
-				c_str()[old_size] = 0;
-				return;
+				const auto data = static_cast<CharType*>(alloc(bytes));
+				memcpy(data, small_, (old_size + 1) * sizeof(CharType));
+				set_heap(data, old_size, new_capacity);
 			}
+			else
+			{
+				set_heap(static_cast<CharType*>(realloc(heap_.data, bytes)), old_size, new_capacity);
+			}
+		}
 
-			if (size_ + 1 <= capacity_)
-				return;
-
-			const bool small_to_heap_transition = old_size <= max_small_string_size;
-
-			while (size_ + 1 > capacity_)
-				capacity_ *= 2;
+		// characters that can be stored without reallocating
+		[[nodiscard]] constexpr size_t capacity() const
+		{
+			return is_small() ? max_small_size : heap_.capacity & capacity_mask;
+		}
 
-			buffer_ = buffer_ ? static_cast<CharType*>(realloc(buffer_, capacity_ * sizeof(CharType)))
-				: static_cast<CharType*>(alloc(capacity_ * sizeof(CharType)));
+		// characters past the old size are left uninitialized
+		constexpr void resize(size_t new_size)
+		{
+			if (new_size > capacity())
+				grow(new_size);
 
-			if (small_to_heap_transition)
-			{
-				// copy memory from buffer to heap
-				memcpy(buffer_, small_buffer_.data(), (max_small_string_size + 1) * sizeof(CharType));
-			}
+			set_size(new_size);
 		}
 
 		constexpr base_string& operator+=(const base_string& rhs)
 		{
-			// append rhs into this
+			// append rhs into this, rhs may be this
 			const auto old_size = size();
-			resize(size() + rhs.size());
-
-			for (size_t i = 0; i < rhs.size(); ++i)
-				c_str()[old_size + i] = rhs[i];
+			const auto rhs_size = rhs.size();
+			resize(old_size + rhs_size);
 
-			c_str()[size_] = 0;
+			memcpy(c_str() + old_size, rhs.c_str(), rhs_size * sizeof(CharType));
 			return *this;
 		}
 
@@ -321,12 +299,9 @@ namespace crt
 			// append rhs into this
 			const auto rhs_size = detail::strlen_imp<CharType>(rhs);
 			const auto old_size = size();
-			resize(size() + rhs_size);
-
-			for (size_t i = 0; i < rhs_size; ++i)
-				c_str()[old_size + i] = rhs[i];
+			resize(old_size + rhs_size);
 
-			c_str()[size_] = 0;
+			memcpy(c_str() + old_size, rhs, rhs_size * sizeof(CharType));
 			return *this;
 		}
 
@@ -338,33 +313,21 @@ namespace crt
 
 		constexpr void push_back(CharType character)
 		{
-			resize(size_ + 1);
-			c_str()[size_ - 1] = character;
-			c_str()[size_] = 0;
+			const auto old_size = size();
+			resize(old_size + 1);
+			c_str()[old_size] = character;
 		}
 
 
 		constexpr void pop_back()
 		{
-			CRT_ASSERT(size_, "String empty pop!");
-			size_ -= 1;
-			c_str()[size_] = 0;
+			CRT_ASSERT(size(), "String empty pop!");
+			set_size(size() - 1);
 		}
 
 		constexpr void insert(iterator pos, CharType ch)
 		{
-			auto idx = pos.ptr_ - c_str();
-			if (idx >= size())
-				return push_back(ch);
-
-			const size_t chars_to_shift = size() - idx;
-			resize(size_ + 1);
-
-			memmove(c_str() + idx + 1, c_str() + idx, chars_to_shift * sizeof(CharType));
-
-
-			c_str()[idx] = ch;
-			c_str()[size_] = 0;
+			insert(pos, &ch, 1);
 		}
 
 		// insert all items in [it_begin..it_end) to the pos
@@ -381,29 +344,22 @@ namespace crt
 				idx = size();
 
 			const size_t chars_to_shift = size() - idx;
-			resize(size_ + count);
+			resize(size() + count);
 
 			if (chars_to_shift)
 				memmove(c_str() + idx + count, c_str() + idx, chars_to_shift * sizeof(CharType));
 
 			memcpy(c_str() + idx, origin, count * sizeof(CharType));
-			c_str()[size_] = 0;
 		}
 
 		[[nodiscard]] constexpr const CharType* c_str() const
 		{
-			if (buffer_)
-				return buffer_;
-
-			return &small_buffer_[0];
+			return is_small() ? small_ : heap_.data;
 		}
 
 		[[nodiscard]] constexpr CharType* c_str()
 		{
-			if (buffer_)
-				return buffer_;
-
-			return &small_buffer_[0];
+			return is_small() ? small_ : heap_.data;
 		}
 
 		[[nodiscard]] constexpr CharType& front()
@@ -421,12 +377,12 @@ namespace crt
 
 		[[nodiscard]] constexpr size_t size() const
 		{
-			return size_;
+			return is_small() ? max_small_size - bytes_[flag_byte] : heap_.size;
 		}
 
 		[[nodiscard]] constexpr bool empty() const
 		{
-			return size_ == 0;
+			return size() == 0;
 		}
 
 		constexpr bool starts_with(const base_string<CharType>& str) const
@@ -434,7 +390,7 @@ namespace crt
 			if (size() < str.size())
 				return false;
 
-			return !detail::strncmp_imp(c_str(), str.c_str(), str.size());
+			return detail::equal_imp(c_str(), str.c_str(), str.size());
 		}
 
 		constexpr bool starts_with(const CharType* str) const
@@ -443,16 +399,13 @@ namespace crt
 			if (size() < len)
 				return false;
 
-			return !detail::strncmp_imp(c_str(), str, len);
+			return detail::equal_imp(c_str(), str, len);
 		}
 
 		// returns first occurrence of s in this, nullptr if can't find
 		constexpr CharType* find(const CharType* s, size_t pos = 0)
 		{
-			if (!c_str())
-				return nullptr;
-
-			return detail::strstr_imp(c_str() + pos, s);
+			return find(s, detail::strlen_imp(s), pos);
 		}
 
 		constexpr bool contains(const CharType* s)
@@ -462,15 +415,21 @@ namespace crt
 
 		constexpr bool contains(const base_string<CharType>& s)
 		{
-			return contains(s.c_str());
+			return find(s) != nullptr;
 		}
 
 		constexpr CharType* find(const base_string<CharType>& s, size_t pos = 0)
 		{
-			if (!c_str() || !s.c_str())
+			return find(s.c_str(), s.size(), pos);
+		}
+
+		// returns first occurrence of the first count characters of s in this, starting at pos. nullptr if can't find
+		constexpr CharType* find(const CharType* s, size_t count, size_t pos)
+		{
+			if (pos > size())
 				return nullptr;
 
-			return detail::strstr_imp(c_str() + pos, s.c_str());
+			return const_cast<CharType*>(detail::find_imp<CharType>(c_str() + pos, size() - pos, s, count));
 		}
 
 		constexpr base_string<CharType> ltrim() const
@@ -512,9 +471,8 @@ namespace crt
 
 			const size_t num_elements_to_shift = end() - position - 1;
 
-			--size_;
-
 			memmove(position, position + 1, num_elements_to_shift * sizeof(CharType));
+			set_size(size() - 1);
 
 			return iterator(position);
 		}
@@ -525,22 +483,100 @@ namespace crt
 		}
 
 	private:
-		// the internal string is always null terminated, size does not include the null terminating character 
-		CharType* buffer_{};
-		// 16 bytes
-		crt::array<CharType, max_small_string_size + 1> small_buffer_;
+		struct heap_representation
+		{
+			CharType* data;
+			size_t size;
+			size_t capacity;	// without the null terminator. on x64 its top byte is the flag byte
+		};
+
+		constexpr static size_t element_count = string_representation_size / sizeof(CharType);
+		constexpr static size_t flag_byte = string_representation_size - 1;
+		constexpr static uint8_t heap_flag = 0x80;
+		constexpr static size_t capacity_mask = sizeof(size_t) == 8 ? ~(size_t(0xFF) << 56) : ~size_t(0);
+
+		static_assert(sizeof(heap_representation) <= string_representation_size, "heap representation does not fit the string");
+
+	public:
+		// characters stored inline without a heap allocation: 23 for char, 11 for 2 byte wchar_t
+		constexpr static size_t max_small_size = element_count - 1;
+
+	private:
+		[[nodiscard]] constexpr bool is_small() const
+		{
+			return !(bytes_[flag_byte] & heap_flag);
+		}
+
+		// the flag byte of a small string holds the unused inline capacity. a full small string stores 0 there,
+		// which then doubles as (the last byte of) its null terminator.
+		constexpr void set_small_size(size_t size)
+		{
+			small_[size] = 0;
+			bytes_[flag_byte] = static_cast<uint8_t>(max_small_size - size);
+		}
 
-		size_t    size_{};
-		size_t    capacity_{ max_small_string_size + 1 };
+		constexpr void set_heap(CharType* data, size_t size, size_t capacity)
+		{
+			heap_.data = data;
+			heap_.size = size;
+			heap_.capacity = capacity;
+			bytes_[flag_byte] = heap_flag;
+		}
+
+		// update the size and write the null terminator
+		constexpr void set_size(size_t size)
+		{
+			if (is_small())
+			{
+				set_small_size(size);
+			}
+			else
+			{
+				heap_.size = size;
+				heap_.data[size] = 0;
+			}
+		}
+
+		// grow geometrically so that repeated appends stay amortized O(1)
+		constexpr void grow(size_t needed_capacity)
+		{
+			const auto doubled = capacity() * 2;
+			reserve(needed_capacity > doubled ? needed_capacity : doubled);
+		}
+
+		constexpr void release()
+		{
+			if (!is_small())
+				free(heap_.data);
+
+			set_small_size(0);
+		}
+
+		// the internal string is always null terminated, size does not include the null terminating character.
+		// 24 bytes: either the heap representation, or up to max_small_size characters inline.
+		// the last byte tells them apart, see set_small_size and set_heap.
+		union
+		{
+			heap_representation heap_;
+			CharType small_[element_count];
+			uint8_t bytes_[string_representation_size];
+		};
 	};
 
 	typedef base_string<char>		string;
 	typedef base_string<wchar_t>	wstring;
 
 
+	// hash of size characters at str, equal to the hash of a base_string holding the same characters
+	template <typename T>
+	size_t get_string_hash(const T* str, size_t size)
+	{
+		return detail::fold_hash(hash_bytes(str, size * sizeof(T)));
+	}
+
 	template <typename T>
-	constexpr size_t get_hash(const base_string<T>& str)
+	size_t get_hash(const base_string<T>& str)
 	{
-		return fnv_1a(reinterpret_cast<const uint8_t*>(str.c_str()), str.size());
+		return get_string_hash(str.c_str(), str.size());
 	}
 }
@@ -1,29 +1,21 @@
 #include "my_time.h"
 #include <Windows.h>
 
-#include "string_utils.hpp"
+#include "format.hpp"
 
 crt::string crt::get_time_display()   
+{
+	char buffer[max_time_display_size];
+	return string{ buffer, write_time_display(buffer) };
+}
+
+size_t crt::write_time_display(char* out)
 {
 	//[hour.minute.sec.ms]
 	SYSTEMTIME st;
 	GetLocalTime(&st);
 
-	string result;
-	result.reserve(64);
-	
-
-	result += "[";
-	result += int_to_dec(st.wDay) + "-";
-	result += int_to_dec(st.wMonth) + "-";
-	result += int_to_dec(st.wYear) + " ";
-
-	result += int_to_dec(st.wHour) + ":";
-	result += int_to_dec(st.wMinute) + ":";
-	result += int_to_dec(st.wSecond) + ":";
-	result += int_to_dec(st.wMilliseconds);
-	result += "] ";
-
-	return result;
+	return format_to(out, "[{}-{}-{} {}:{}:{}:{}] ", st.wDay, st.wMonth, st.wYear,
+		st.wHour, st.wMinute, st.wSecond, st.wMilliseconds) - out;
 }
 
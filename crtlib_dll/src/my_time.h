@@ -4,5 +4,11 @@
 
 namespace crt
 {
+	// "[day-month-year hour:minute:sec:ms] " fits in this many characters
+	constexpr size_t max_time_display_size = 48;
+
 	string get_time_display(); // [hour.minute.sec.ms]
+
+	// writes the same text to out without allocating, returns the number of characters written
+	size_t write_time_display(char* out);
 }
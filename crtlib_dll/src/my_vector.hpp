@@ -542,13 +542,21 @@ namespace crt
 	};
 
 	template <typename T>
-	constexpr size_t get_hash(const vector<T>& vec)
+	size_t get_hash(const vector<T>& vec)
 	{
-		size_t seed = 0;
-		for (const auto& element : vec)
+		// elements without padding or multiple representations of the same value are hashed as one buffer
+		if constexpr (std::has_unique_object_representations_v<T>)
 		{
-			hash_combine(seed, element);
+			return detail::fold_hash(hash_bytes(vec.data(), vec.size() * sizeof(T)));
+		}
+		else
+		{
+			size_t seed = 0;
+			for (const auto& element : vec)
+			{
+				hash_combine(seed, element);
+			}
+			return seed;
 		}
-		return seed;
 	}
 }
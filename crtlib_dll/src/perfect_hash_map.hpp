@@ -0,0 +1,310 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+#include "c_string.hpp"
+#include "pair.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		// not constexpr on purpose, reaching a call to this while building the table at compile time fails the compilation.
+		void perfect_hash_build_failed(const char* reason);
+
+		// murmur3 finalizer
+		constexpr uint64_t perfect_hash_mix(uint64_t h)
+		{
+			h ^= h >> 33;
+			h *= 0xff51afd7ed558ccdull;
+			h ^= h >> 33;
+			h *= 0xc4ceb9fe1a85ec53ull;
+			h ^= h >> 33;
+			return h;
+		}
+
+		template <typename K, typename = void>
+		struct perfect_hash_key_traits
+		{
+			static_assert(std::is_integral_v<K> || std::is_enum_v<K>, "perfect_hash_map keys must be integral, enum or string literals");
+
+			constexpr static uint64_t hash(K key, uint64_t seed)
+			{
+				return perfect_hash_mix(static_cast<uint64_t>(key) ^ seed);
+			}
+
+			constexpr static bool equal(K lhs, K rhs)
+			{
+				return lhs == rhs;
+			}
+		};
+
+		template <typename CharType>
+		struct perfect_hash_key_traits<const CharType*, std::enable_if_t<std::is_same_v<CharType, char> || std::is_same_v<CharType, wchar_t>>>
+		{
+			// seeded FNV-1a over the characters followed by a finalizer
+			constexpr static uint64_t hash(const CharType* key, size_t size, uint64_t seed)
+			{
+				uint64_t hash = 14695981039346656037ull ^ seed;
+				for (size_t i = 0; i < size; ++i)
+				{
+					hash ^= static_cast<uint64_t>(key[i]);
+					hash *= 1099511628211ull;
+				}
+
+				return perfect_hash_mix(hash);
+			}
+
+			constexpr static uint64_t hash(const CharType* key, uint64_t seed)
+			{
+				return hash(key, strlen_imp(key), seed);
+			}
+
+			constexpr static bool equal(const CharType* lhs, const CharType* rhs)
+			{
+				return !strcmp_imp(lhs, rhs);
+			}
+
+			constexpr static bool equal(const CharType* lhs, const CharType* rhs, size_t rhs_size)
+			{
+				return !strncmp_imp(lhs, rhs, rhs_size) && lhs[rhs_size] == 0;
+			}
+		};
+	}
+
+	// immutable map whose table is built at compile time from literal keys (CHD, "compress, hash and displace").
+	// every key is hashed once with a global seed. the upper bits of the hash select a bucket, the bucket's
+	// displacement pair (d0, d1) turns the lower bits into a collision free slot: (f1 + d0 * f2 + d1) & (table_size - 1).
+	// lookup is therefore one hash, one index and one key compare, with no probing.
+	//
+	// constexpr auto commands = crt::make_perfect_hash_map<const char*, int>({ {"open", 1}, {"close", 2} });
+	// const int* command = commands.find("close");
+	//
+	// building is done by the compiler. large tables (hundreds of keys) may need a higher /constexpr:steps limit.
+	template <typename K, typename V, size_t N>
+	class perfect_hash_map
+	{
+		using traits = detail::perfect_hash_key_traits<K>;
+
+		constexpr static size_t round_to_power_of_2(size_t value)
+		{
+			size_t result = 1;
+			while (result < value)
+				result <<= 1;
+			return result;
+		}
+
+	public:
+		static_assert(N > 0, "perfect_hash_map needs at least one key");
+
+		constexpr static size_t table_size = round_to_power_of_2(N);
+		constexpr static size_t bucket_count = N / 2 + 1;
+
+		consteval explicit perfect_hash_map(const crt::pair<K, V>(&entries)[N])
+		{
+			uint64_t hashes[N]{};
+
+			for (uint64_t seed = 0; seed < max_seed_attempts; ++seed)
+			{
+				seed_ = detail::perfect_hash_mix(seed + 1);
+
+				for (size_t i = 0; i < N; ++i)
+					hashes[i] = traits::hash(entries[i].first(), seed_);
+
+				if (seed == 0 && has_duplicate_keys(entries, hashes))
+					detail::perfect_hash_build_failed("perfect_hash_map contains duplicate keys");
+
+				if (try_build(entries, hashes))
+					return;
+			}
+
+			detail::perfect_hash_build_failed("perfect_hash_map could not find a collision free table");
+		}
+
+		// returns nullptr if the key does not exist
+		constexpr const V* find(K key) const
+		{
+			const auto slot = slot_of(traits::hash(key, seed_));
+			return traits::equal(keys_[slot], key) ? &values_[slot] : nullptr;
+		}
+
+		// lookup by non null terminated string, for maps with string literal keys. find(str.c_str(), str.size())
+		template <typename CharType, typename Key = K>
+		constexpr std::enable_if_t<std::is_same_v<Key, const CharType*>, const V*> find(const CharType* key, size_t size) const
+		{
+			const auto slot = slot_of(traits::hash(key, size, seed_));
+			return traits::equal(keys_[slot], key, size) ? &values_[slot] : nullptr;
+		}
+
+		constexpr bool contains(K key) const
+		{
+			return find(key) != nullptr;
+		}
+
+		constexpr size_t size() const
+		{
+			return N;
+		}
+
+	private:
+		struct displacement
+		{
+			uint32_t d0;
+			uint32_t d1;
+		};
+
+		constexpr static uint64_t max_seed_attempts = 32;
+
+		constexpr static size_t bucket_of(uint64_t hash)
+		{
+			// map the upper 32 bits to [0, bucket_count) without a division
+			return static_cast<size_t>(((hash >> 32) * bucket_count) >> 32);
+		}
+
+		constexpr static size_t position_of(uint64_t hash, const displacement& d)
+		{
+			const auto f1 = static_cast<uint32_t>(hash);
+			const auto f2 = static_cast<uint32_t>(hash >> 32) | 1; // odd, so d0 walks every slot
+
+			return (f1 + d.d0 * f2 + d.d1) & (table_size - 1);
+		}
+
+		constexpr size_t slot_of(uint64_t hash) const
+		{
+			return position_of(hash, displacements_[bucket_of(hash)]);
+		}
+
+		constexpr static bool has_duplicate_keys(const crt::pair<K, V>(&entries)[N], const uint64_t(&hashes)[N])
+		{
+			// equal keys always have equal hashes, only compare those
+			for (size_t i = 0; i < N; ++i)
+			{
+				for (size_t j = i + 1; j < N; ++j)
+				{
+					if (hashes[i] == hashes[j] && traits::equal(entries[i].first(), entries[j].first()))
+						return true;
+				}
+			}
+
+			return false;
+		}
+
+		// place the buckets from the largest to the smallest, searching a displacement that lands all keys
+		// of the bucket on free slots. returns false if the seed should be changed.
+		constexpr bool try_build(const crt::pair<K, V>(&entries)[N], const uint64_t(&hashes)[N])
+		{
+			size_t bucket_sizes[bucket_count]{};
+			size_t bucket_start[bucket_count + 1]{};
+			size_t bucket_order[bucket_count]{};
+			size_t bucket_keys[N]{};	// key indexes grouped by bucket
+			bool taken[table_size]{};
+
+			for (size_t i = 0; i < N; ++i)
+				++bucket_sizes[bucket_of(hashes[i])];
+
+			for (size_t b = 0; b < bucket_count; ++b)
+				bucket_start[b + 1] = bucket_start[b] + bucket_sizes[b];
+
+			{
+				size_t fill[bucket_count]{};
+				for (size_t i = 0; i < N; ++i)
+				{
+					const auto b = bucket_of(hashes[i]);
+					bucket_keys[bucket_start[b] + fill[b]++] = i;
+				}
+			}
+
+			for (size_t b = 0; b < bucket_count; ++b)
+			{
+				// insertion sort by decreasing bucket size
+				size_t j = b;
+				while (j > 0 && bucket_sizes[bucket_order[j - 1]] < bucket_sizes[b])
+				{
+					bucket_order[j] = bucket_order[j - 1];
+					--j;
+				}
+				bucket_order[j] = b;
+			}
+
+			for (size_t b = 0; b < bucket_count; ++b)
+			{
+				const auto bucket = bucket_order[b];
+				if (!bucket_sizes[bucket])
+					break;
+
+				if (!place_bucket(bucket, bucket_keys + bucket_start[bucket], bucket_sizes[bucket], hashes, taken))
+					return false;
+			}
+
+			// fill unused slots with a real key. such a key always hashes to its own slot,
+			// so a lookup landing on a filler slot fails the key compare without a separate occupied flag.
+			for (size_t i = 0; i < table_size; ++i)
+			{
+				keys_[i] = entries[0].first();
+				values_[i] = entries[0].second();
+			}
+
+			for (size_t i = 0; i < N; ++i)
+			{
+				const auto slot = slot_of(hashes[i]);
+				keys_[slot] = entries[i].first();
+				values_[slot] = entries[i].second();
+			}
+
+			return true;
+		}
+
+		constexpr bool place_bucket(size_t bucket, const size_t* keys, size_t count, const uint64_t(&hashes)[N], bool(&taken)[table_size])
+		{
+			size_t slots[N]{};
+
+			for (uint32_t d0 = 0; d0 < table_size; ++d0)
+			{
+				for (uint32_t d1 = 0; d1 < table_size; ++d1)
+				{
+					const displacement d{ d0, d1 };
+
+					size_t placed = 0;
+					for (; placed < count; ++placed)
+					{
+						const auto slot = position_of(hashes[keys[placed]], d);
+						if (taken[slot])
+							break;
+
+						// keys of the same bucket must not collide with each other either
+						bool collides = false;
+						for (size_t j = 0; j < placed && !collides; ++j)
+							collides = slots[j] == slot;
+
+						if (collides)
+							break;
+
+						slots[placed] = slot;
+					}
+
+					if (placed == count)
+					{
+						for (size_t j = 0; j < count; ++j)
+							taken[slots[j]] = true;
+
+						displacements_[bucket] = d;
+						return true;
+					}
+				}
+			}
+
+			return false;
+		}
+
+		uint64_t seed_{};
+		displacement displacements_[bucket_count]{};
+		K keys_[table_size]{};
+		V values_[table_size]{};
+	};
+
+	template <typename K, typename V, size_t N>
+	consteval perfect_hash_map<K, V, N> make_perfect_hash_map(const crt::pair<K, V>(&entries)[N])
+	{
+		return perfect_hash_map<K, V, N>(entries);
+	}
+}
@@ -0,0 +1,415 @@
+#include "rope.hpp"
+#include <intrin.h>
+
+#include "assert.h"
+#include "heap_allocator.h"
+
+namespace crt
+{
+	using detail::rope_node;
+
+	static uint32_t height_of(const rope_node* node)
+	{
+		return node ? node->height : 0;
+	}
+
+	static rope_node* retain(rope_node* node)
+	{
+		if (node)
+			_InterlockedIncrement(&node->references);
+
+		return node;
+	}
+
+	static void release(rope_node* node)
+	{
+		if (!node || _InterlockedDecrement(&node->references))
+			return;
+
+		if (!node->is_leaf())
+		{
+			release(node->left);
+			release(node->right);
+		}
+
+		free(node);
+	}
+
+	static size_t count_lines(const char* text, size_t size)
+	{
+		size_t lines = 0;
+		for (size_t i = 0; i < size; ++i)
+			lines += text[i] == '\n';
+
+		return lines;
+	}
+
+	static rope_node* make_leaf(const char* text, size_t size)
+	{
+		const auto node = static_cast<rope_node*>(alloc(sizeof(rope_node) + size));
+		node->references = 1;
+		node->length = size;
+		node->lines = count_lines(text, size);
+		node->height = 0;
+		node->left = nullptr;
+		node->right = nullptr;
+
+		memcpy(node + 1, text, size);
+		return node;
+	}
+
+	// takes over the references to left and right
+	static rope_node* make_inner(rope_node* left, rope_node* right)
+	{
+		const auto node = static_cast<rope_node*>(alloc(sizeof(rope_node)));
+		node->references = 1;
+		node->length = left->length + right->length;
+		node->lines = left->lines + right->lines;
+		node->height = (left->height > right->height ? left->height : right->height) + 1;
+		node->left = left;
+		node->right = right;
+		return node;
+	}
+
+	static void copy_text(const rope_node* node, char* out)
+	{
+		auto copy = [&out](const char* chunk, size_t size)
+		{
+			memcpy(out, chunk, size);
+			out += size;
+		};
+
+		detail::rope_for_each_leaf(node, copy);
+	}
+
+	static rope_node* join(rope_node* left, rope_node* right);
+
+	// joins two avl trees whose heights differ by at most 2 under a new node, rotating the taller side once
+	// or twice like an avl insertion. the tree is immutable, the rotated path is rebuilt and the old nodes released.
+	static rope_node* balance(rope_node* left, rope_node* right)
+	{
+		if (height_of(left) > height_of(right) + 1)
+		{
+			const auto a = retain(left->left);
+			const auto b = retain(left->right);
+			release(left);
+
+			// (a, b), c -> (a, (b, c))
+			if (height_of(a) >= height_of(b))
+				return make_inner(a, make_inner(b, right));
+
+			// (a, (b1, b2)), c -> ((a, b1), (b2, c))
+			const auto b1 = retain(b->left);
+			const auto b2 = retain(b->right);
+			release(b);
+			return make_inner(make_inner(a, b1), make_inner(b2, right));
+		}
+
+		if (height_of(right) > height_of(left) + 1)
+		{
+			const auto b = retain(right->left);
+			const auto c = retain(right->right);
+			release(right);
+
+			// a, (b, c) -> ((a, b), c)
+			if (height_of(c) >= height_of(b))
+				return make_inner(make_inner(left, b), c);
+
+			// a, ((b1, b2), c) -> ((a, b1), (b2, c))
+			const auto b1 = retain(b->left);
+			const auto b2 = retain(b->right);
+			release(b);
+			return make_inner(make_inner(left, b1), make_inner(b2, c));
+		}
+
+		return make_inner(left, right);
+	}
+
+	// merging small leaves can leave a joined subtree more than 2 levels shorter than its new sibling,
+	// a full join walks down the taller one instead
+	static rope_node* attach(rope_node* left, rope_node* right)
+	{
+		const auto left_height = height_of(left);
+		const auto right_height = height_of(right);
+		if (left_height > right_height + 2 || right_height > left_height + 2)
+			return join(left, right);
+
+		return balance(left, right);
+	}
+
+	// left is more than one level taller than right, walk down its right spine to a subtree of matching height
+	static rope_node* join_right(rope_node* left, rope_node* right)
+	{
+		const auto l = retain(left->left);
+		const auto c = retain(left->right);
+		release(left);
+
+		return attach(l, join(c, right));
+	}
+
+	static rope_node* join_left(rope_node* left, rope_node* right)
+	{
+		const auto c = retain(right->left);
+		const auto r = retain(right->right);
+		release(right);
+
+		return attach(join(left, c), r);
+	}
+
+	// concatenates two trees, takes over both references. small neighbours are merged into a single leaf,
+	// so repeated edits at the same place do not leave a trail of tiny leaves behind.
+	static rope_node* join(rope_node* left, rope_node* right)
+	{
+		if (!left)
+			return right;
+
+		if (!right)
+			return left;
+
+		const auto length = left->length + right->length;
+		if (length <= rope::max_leaf_size)
+		{
+			char buffer[rope::max_leaf_size];
+			copy_text(left, buffer);
+			copy_text(right, buffer + left->length);
+			release(left);
+			release(right);
+
+			return make_leaf(buffer, length);
+		}
+
+		if (left->height > right->height + 1)
+			return join_right(left, right);
+
+		if (right->height > left->height + 1)
+			return join_left(left, right);
+
+		return make_inner(left, right);
+	}
+
+	// splits the subtree at index without modifying it, left and right receive new references
+	static void split(rope_node* node, size_t index, rope_node*& left, rope_node*& right)
+	{
+		if (!node || index == 0)
+		{
+			left = nullptr;
+			right = retain(node);
+			return;
+		}
+
+		if (index >= node->length)
+		{
+			left = retain(node);
+			right = nullptr;
+			return;
+		}
+
+		if (node->is_leaf())
+		{
+			left = make_leaf(node->text(), index);
+			right = make_leaf(node->text() + index, node->length - index);
+			return;
+		}
+
+		rope_node* a;
+		rope_node* b;
+		const auto left_length = node->left->length;
+		if (index <= left_length)
+		{
+			split(node->left, index, a, b);
+			left = a;
+			right = join(b, retain(node->right));
+		}
+		else
+		{
+			split(node->right, index - left_length, a, b);
+			left = join(retain(node->left), a);
+			right = b;
+		}
+	}
+
+	// balanced tree of full leaves
+	static rope_node* build(const char* text, size_t size)
+	{
+		if (size <= rope::max_leaf_size)
+			return size ? make_leaf(text, size) : nullptr;
+
+		const auto leaves = (size + rope::max_leaf_size - 1) / rope::max_leaf_size;
+		const auto middle = leaves / 2 * rope::max_leaf_size;
+		return make_inner(build(text, middle), build(text + middle, size - middle));
+	}
+
+	rope::rope(const char* str) : rope(str, strlen(str))
+	{
+	}
+
+	rope::rope(const char* str, size_t size) : root_(build(str, size))
+	{
+	}
+
+	rope::rope(const string& str) : rope(str.c_str(), str.size())
+	{
+	}
+
+	rope::rope(const rope& other) : root_(retain(other.root_))
+	{
+	}
+
+	rope& rope::operator=(const rope& other)
+	{
+		const auto old_root = root_;
+		root_ = retain(other.root_);
+		release(old_root);
+		return *this;
+	}
+
+	rope::rope(rope&& other) noexcept : root_(other.root_)
+	{
+		other.root_ = nullptr;
+	}
+
+	rope& rope::operator=(rope&& other) noexcept
+	{
+		if (this != &other)
+		{
+			release(root_);
+			root_ = other.root_;
+			other.root_ = nullptr;
+		}
+
+		return *this;
+	}
+
+	rope::~rope()
+	{
+		release(root_);
+	}
+
+	char rope::operator[](size_t index) const
+	{
+		CRT_ASSERT(index < size(), "rope out of bounds access!");
+
+		auto node = root_;
+		while (!node->is_leaf())
+		{
+			if (index < node->left->length)
+			{
+				node = node->left;
+			}
+			else
+			{
+				index -= node->left->length;
+				node = node->right;
+			}
+		}
+
+		return node->text()[index];
+	}
+
+	size_t rope::line_offset(size_t line) const
+	{
+		if (!line)
+			return 0;
+
+		CRT_ASSERT(root_ && line <= root_->lines, "rope line out of range!");
+
+		// the line starts after its line-th '\n'
+		size_t offset = 0;
+		auto node = root_;
+		while (!node->is_leaf())
+		{
+			if (line <= node->left->lines)
+			{
+				node = node->left;
+			}
+			else
+			{
+				line -= node->left->lines;
+				offset += node->left->length;
+				node = node->right;
+			}
+		}
+
+		for (size_t i = 0; ; ++i)
+		{
+			if (node->text()[i] == '\n' && !--line)
+				return offset + i + 1;
+		}
+	}
+
+	void rope::insert(size_t position, const char* str, size_t size)
+	{
+		CRT_ASSERT(position <= this->size(), "rope insert out of bounds!");
+		if (!size)
+			return;
+
+		rope_node* left;
+		rope_node* right;
+		split(root_, position, left, right);
+		release(root_);
+
+		root_ = join(join(left, build(str, size)), right);
+	}
+
+	void rope::insert(size_t position, const rope& other)
+	{
+		CRT_ASSERT(position <= size(), "rope insert out of bounds!");
+
+		// retained first, other may be this
+		const auto middle = retain(other.root_);
+
+		rope_node* left;
+		rope_node* right;
+		split(root_, position, left, right);
+		release(root_);
+
+		root_ = join(join(left, middle), right);
+	}
+
+	void rope::erase(size_t position, size_t count)
+	{
+		if (position >= size() || !count)
+			return;
+
+		rope_node* left;
+		rope_node* rest;
+		split(root_, position, left, rest);
+
+		rope_node* removed;
+		rope_node* right;
+		split(rest, count, removed, right);
+
+		release(rest);
+		release(removed);
+		release(root_);
+		root_ = join(left, right);
+	}
+
+	rope rope::substring(size_t position, size_t count) const
+	{
+		if (position >= size() || !count)
+			return rope();
+
+		rope_node* left;
+		rope_node* rest;
+		split(root_, position, left, rest);
+
+		rope_node* middle;
+		rope_node* right;
+		split(rest, count, middle, right);
+
+		release(left);
+		release(rest);
+		release(right);
+		return rope(middle);
+	}
+
+	string rope::to_string() const
+	{
+		string result;
+		result.reserve(size());
+		result.resize(size());
+		copy_text(root_, result.c_str());
+		return result;
+	}
+}
@@ -0,0 +1,146 @@
+#pragma once
+#include <cstdint>
+
+#include "my_string.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		// rope nodes are immutable once built and shared between ropes through the reference count,
+		// which is atomic since the ropes sharing a node may live on different threads.
+		// a leaf (height 0) stores its characters right after the header, an inner node joins two subtrees.
+		struct rope_node
+		{
+			volatile long references;
+			size_t length;		// characters in the subtree
+			size_t lines;		// '\n' characters in the subtree
+			uint32_t height;
+			rope_node* left;
+			rope_node* right;
+
+			bool is_leaf() const
+			{
+				return height == 0;
+			}
+
+			const char* text() const
+			{
+				return reinterpret_cast<const char*>(this + 1);
+			}
+		};
+
+		template <typename F>
+		void rope_for_each_leaf(const rope_node* node, F& f)
+		{
+			if (!node)
+				return;
+
+			if (node->is_leaf())
+			{
+				f(node->text(), node->length);
+				return;
+			}
+
+			rope_for_each_leaf(node->left, f);
+			rope_for_each_leaf(node->right, f);
+		}
+	}
+
+	// text buffer for large strings that are edited in the middle. the text is split into chunks of up to
+	// rope::max_leaf_size characters at the leaves of an avl balanced tree, so insert, erase and substring
+	// are O(log n) instead of moving the whole tail. nodes are shared, copying a rope is O(1) and the copy is
+	// a snapshot that later edits of either rope do not affect. every node caches its length and line count.
+	// a copy can be handed to another thread and read, edited or destroyed there while the original is edited,
+	// the shared nodes are never written and their reference counts are atomic. a single rope object is not
+	// thread safe, like any other container.
+	class rope
+	{
+	public:
+		constexpr static size_t max_leaf_size = 512;
+
+		rope() = default;
+		rope(const char* str);
+		rope(const char* str, size_t size);
+		explicit rope(const string& str);
+
+		rope(const rope& other);
+		rope& operator=(const rope& other);
+		rope(rope&& other) noexcept;
+		rope& operator=(rope&& other) noexcept;
+		~rope();
+
+		size_t size() const
+		{
+			return root_ ? root_->length : 0;
+		}
+
+		bool empty() const
+		{
+			return !root_;
+		}
+
+		// number of lines, one more than the number of '\n' characters
+		size_t line_count() const
+		{
+			return (root_ ? root_->lines : 0) + 1;
+		}
+
+		// O(log n)
+		char operator[](size_t index) const;
+
+		// offset of the first character of line, lines are counted from 0
+		size_t line_offset(size_t line) const;
+
+		void insert(size_t position, const char* str, size_t size);
+		void insert(size_t position, const rope& other);
+
+		void insert(size_t position, const char* str)
+		{
+			insert(position, str, strlen(str));
+		}
+
+		void insert(size_t position, const string& str)
+		{
+			insert(position, str.c_str(), str.size());
+		}
+
+		void append(const char* str, size_t size)
+		{
+			insert(this->size(), str, size);
+		}
+
+		void append(const rope& other)
+		{
+			insert(size(), other);
+		}
+
+		// removes up to count characters starting at position
+		void erase(size_t position, size_t count);
+
+		// up to count characters starting at position, sharing the nodes of this rope
+		rope substring(size_t position, size_t count) const;
+
+		// calls f(const char* chunk, size_t size) for every chunk in order
+		template <typename F>
+		void for_each_chunk(F f) const
+		{
+			detail::rope_for_each_leaf(root_, f);
+		}
+
+		// the whole text with a single allocation
+		string to_string() const;
+
+		friend rope operator+(const rope& lhs, const rope& rhs)
+		{
+			rope result = lhs;
+			result.append(rhs);
+			return result;
+		}
+
+	private:
+		explicit rope(detail::rope_node* root) : root_(root) {}
+
+		detail::rope_node* root_{};
+	};
+}
@@ -0,0 +1,236 @@
+#pragma once
+#include <cstdint>
+#include <intrin.h>
+
+#include "assert.h"
+#include "heap_allocator.h"
+#include "my_memory.h"
+#include "my_string.hpp"
+
+namespace crt
+{
+	namespace detail
+	{
+		// one allocation: this header, the characters and a null terminator
+		struct shared_string_header
+		{
+			volatile long references;
+			size_t size;
+			size_t hash;
+		};
+	}
+
+	// immutable reference counted string. copies share the buffer, so passing the same text to many consumers
+	// costs an atomic increment instead of an allocation, from any thread. the hash is computed once when the
+	// buffer is created. substring returns a view into the same buffer.
+	template <typename CharType>
+	class base_shared_string
+	{
+	public:
+		base_shared_string() = default;
+
+		base_shared_string(const CharType* str) : base_shared_string(str, detail::strlen_imp(str))
+		{
+		}
+
+		// copies the characters once into the shared buffer
+		base_shared_string(const CharType* str, size_t size)
+		{
+			if (!size)
+				return;
+
+			header_ = static_cast<detail::shared_string_header*>(alloc(sizeof(detail::shared_string_header) + (size + 1) * sizeof(CharType)));
+			header_->references = 1;
+			header_->size = size;
+
+			const auto text = characters(header_);
+			memcpy(text, str, size * sizeof(CharType));
+			text[size] = 0;
+
+			header_->hash = get_string_hash(text, size);
+			size_ = size;
+		}
+
+		explicit base_shared_string(const base_string<CharType>& str) : base_shared_string(str.c_str(), str.size())
+		{
+		}
+
+		base_shared_string(const base_shared_string& other) : header_(other.header_), offset_(other.offset_), size_(other.size_)
+		{
+			retain();
+		}
+
+		base_shared_string& operator=(const base_shared_string& other)
+		{
+			if (this != &other)
+			{
+				other.retain();
+				release();
+
+				header_ = other.header_;
+				offset_ = other.offset_;
+				size_ = other.size_;
+			}
+
+			return *this;
+		}
+
+		base_shared_string(base_shared_string&& other) noexcept
+		{
+			swap(*this, other);
+		}
+
+		base_shared_string& operator=(base_shared_string&& other) noexcept
+		{
+			base_shared_string dead;
+			swap(*this, dead);
+			swap(*this, other);
+			return *this;
+		}
+
+		friend void swap(base_shared_string& lhs, base_shared_string& rhs) noexcept
+		{
+			crt::swap(lhs.header_, rhs.header_);
+			crt::swap(lhs.offset_, rhs.offset_);
+			crt::swap(lhs.size_, rhs.size_);
+		}
+
+		~base_shared_string()
+		{
+			release();
+		}
+
+		// not null terminated for a substring that ends before the end of the buffer, see c_str
+		const CharType* data() const
+		{
+			return header_ ? characters(header_) + offset_ : empty_string();
+		}
+
+		// only for strings that reach the end of their buffer, every string except for some substrings
+		const CharType* c_str() const
+		{
+			CRT_ASSERT(is_terminated(), "shared_string substring is not null terminated!");
+			return data();
+		}
+
+		bool is_terminated() const
+		{
+			return !header_ || offset_ + size_ == header_->size;
+		}
+
+		size_t size() const
+		{
+			return size_;
+		}
+
+		bool empty() const
+		{
+			return !size_;
+		}
+
+		const CharType& operator[](size_t index) const
+		{
+			CRT_ASSERT(index < size_, "shared_string out of bounds access!");
+			return data()[index];
+		}
+
+		const CharType* begin() const
+		{
+			return data();
+		}
+
+		const CharType* end() const
+		{
+			return data() + size_;
+		}
+
+		// same as get_hash of a base_string with the same characters. cached unless this is a substring
+		size_t hash() const
+		{
+			if (header_ && size_ == header_->size)
+				return header_->hash;
+
+			return get_string_hash(data(), size_);
+		}
+
+		// up to count characters starting at position, sharing this buffer
+		base_shared_string substring(size_t position, size_t count) const
+		{
+			if (position >= size_ || !count)
+				return base_shared_string();
+
+			base_shared_string result = *this;
+			result.offset_ += position;
+			result.size_ = count < size_ - position ? count : size_ - position;
+			return result;
+		}
+
+		base_string<CharType> to_string() const
+		{
+			return base_string<CharType>(data(), size_);
+		}
+
+		// number of strings sharing the buffer
+		long use_count() const
+		{
+			return header_ ? header_->references : 0;
+		}
+
+		friend bool operator==(const base_shared_string& lhs, const base_shared_string& rhs)
+		{
+			if (lhs.size_ != rhs.size_)
+				return false;
+
+			if (lhs.header_ == rhs.header_ && lhs.offset_ == rhs.offset_)
+				return true;
+
+			return detail::equal_imp(lhs.data(), rhs.data(), lhs.size_);
+		}
+
+		friend bool operator!=(const base_shared_string& lhs, const base_shared_string& rhs)
+		{
+			return !(lhs == rhs);
+		}
+
+		friend bool operator==(const base_shared_string& lhs, const CharType* rhs)
+		{
+			const auto size = detail::strlen_imp(rhs);
+			return lhs.size_ == size && detail::equal_imp(lhs.data(), rhs, size);
+		}
+
+	private:
+		static CharType* characters(detail::shared_string_header* header)
+		{
+			return reinterpret_cast<CharType*>(header + 1);
+		}
+
+		static const CharType* empty_string()
+		{
+			static constexpr CharType empty[1] = {};
+			return empty;
+		}
+
+		void retain() const
+		{
+			if (header_)
+				_InterlockedIncrement(&header_->references);
+		}
+
+		void release()
+		{
+			if (header_ && !_InterlockedDecrement(&header_->references))
+				free(header_);
+
+			header_ = nullptr;
+			offset_ = 0;
+			size_ = 0;
+		}
+
+		detail::shared_string_header* header_{};
+		size_t offset_{};
+		size_t size_{};
+	};
+
+	typedef base_shared_string<char>		shared_string;
+	typedef base_shared_string<wchar_t>		shared_wstring;
+}
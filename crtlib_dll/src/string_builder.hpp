@@ -0,0 +1,277 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+#include "charconv.hpp"
+#include "my_memory.h"
+#include "my_string.hpp"
+#include "my_vector.hpp"
+
+namespace crt
+{
+	// integer printed as upper case hex without leading zeros, like int_to_hex
+	template <typename IntType>
+	struct hex_integer
+	{
+		IntType value;
+	};
+
+	// concat("address: ", crt::hex(p)) == "address: 7FF6A000"
+	template <typename IntType>
+	constexpr hex_integer<IntType> hex(IntType value)
+	{
+		return hex_integer<IntType>{ value };
+	}
+
+	namespace detail
+	{
+		constexpr size_t max_float_decimals = 9;
+
+		// a piece of text to be joined: either a view of characters that live elsewhere,
+		// or a number formatted into the inline buffer
+		template <typename CharType>
+		struct string_piece
+		{
+			constexpr static size_t inline_capacity = 32;
+
+			const CharType* view{};		// nullptr if the characters are in inline_buffer
+			size_t size{};
+			CharType inline_buffer[inline_capacity];
+
+			const CharType* data() const
+			{
+				return view ? view : inline_buffer;
+			}
+		};
+
+		template <typename CharType>
+		string_piece<CharType> make_piece(const CharType* str, size_t size)
+		{
+			string_piece<CharType> piece;
+			piece.view = str;
+			piece.size = size;
+			return piece;
+		}
+
+		template <typename CharType>
+		string_piece<CharType> make_piece(const CharType* str)
+		{
+			return make_piece(str, strlen_imp(str));
+		}
+
+		// strings appended as views: base_string, atom and anything else that exposes c_str() and size()
+		template <typename CharType, typename T, typename = void>
+		struct has_c_str : std::false_type
+		{
+		};
+
+		template <typename CharType, typename T>
+		struct has_c_str<CharType, T, std::void_t<decltype(std::declval<const T&>().c_str())>>
+			: std::is_same<decltype(std::declval<const T&>().c_str()), const CharType*>
+		{
+		};
+
+		// a temporary string is destroyed before build() reads its view
+		template <typename CharType, typename T>
+		constexpr bool is_temporary_string_v = !std::is_lvalue_reference_v<T> && has_c_str<CharType, std::remove_cvref_t<T>>::value;
+
+		template <typename CharType, typename T>
+		auto make_piece(const T& str) -> std::enable_if_t<std::is_same_v<decltype(str.c_str()), const CharType*>, string_piece<CharType>>
+		{
+			return make_piece(str.c_str(), str.size());
+		}
+
+		template <typename CharType>
+		string_piece<CharType> make_piece(CharType character)
+		{
+			string_piece<CharType> piece;
+			piece.inline_buffer[0] = character;
+			piece.size = 1;
+			return piece;
+		}
+
+		template <typename IntType>
+		constexpr bool is_printable_integer_v = std::is_integral_v<IntType> && !std::is_same_v<IntType, bool> &&
+			!std::is_same_v<IntType, char> && !std::is_same_v<IntType, wchar_t>;
+
+		template <typename CharType, typename IntType>
+		std::enable_if_t<is_printable_integer_v<IntType>, string_piece<CharType>> make_piece(IntType value)
+		{
+			string_piece<CharType> piece;
+			const auto result = to_chars(piece.inline_buffer, piece.inline_buffer + string_piece<CharType>::inline_capacity, value);
+			piece.size = result.end - piece.inline_buffer;
+			return piece;
+		}
+
+		template <typename CharType, typename IntType>
+		string_piece<CharType> make_piece(hex_integer<IntType> value)
+		{
+			string_piece<CharType> piece;
+			const auto unsigned_value = static_cast<std::make_unsigned_t<IntType>>(value.value);
+			const auto result = to_chars(piece.inline_buffer, piece.inline_buffer + string_piece<CharType>::inline_capacity, unsigned_value, 16);
+			piece.size = result.end - piece.inline_buffer;
+			return piece;
+		}
+
+		// "1" and "0", like int_to_dec
+		template <typename CharType>
+		string_piece<CharType> make_piece(bool value)
+		{
+			return make_piece<CharType>(static_cast<CharType>(value ? '1' : '0'));
+		}
+
+		// fixed with decimals digits after the point. values whose fixed form does not fit the inline buffer
+		// fall back to the shortest representation, which is scientific for them.
+		template <typename CharType>
+		string_piece<CharType> make_float_piece(double value, size_t decimals)
+		{
+			if (decimals > max_float_decimals)
+				decimals = max_float_decimals;
+
+			string_piece<CharType> piece;
+			const auto buffer_end = piece.inline_buffer + string_piece<CharType>::inline_capacity;
+
+			auto result = to_chars(piece.inline_buffer, buffer_end, value, static_cast<uint32_t>(decimals));
+			if (result.error != chars_error::none)
+				result = to_chars(piece.inline_buffer, buffer_end, value);
+
+			piece.size = result.end - piece.inline_buffer;
+			return piece;
+		}
+
+		// shortest representation that parses back to the same value
+		template <typename CharType, typename FloatType>
+		std::enable_if_t<std::is_floating_point_v<FloatType>, string_piece<CharType>> make_piece(FloatType value)
+		{
+			string_piece<CharType> piece;
+			const auto result = to_chars(piece.inline_buffer, piece.inline_buffer + string_piece<CharType>::inline_capacity, value);
+			piece.size = result.end - piece.inline_buffer;
+			return piece;
+		}
+
+		// one allocation for the result and one copy per piece
+		template <typename CharType>
+		base_string<CharType> join_pieces(const string_piece<CharType>* pieces, size_t count, size_t total_size)
+		{
+			base_string<CharType> result;
+			result.reserve(total_size);
+			result.resize(total_size);
+
+			auto out = result.c_str();
+			for (size_t i = 0; i < count; ++i)
+			{
+				memcpy(out, pieces[i].data(), pieces[i].size * sizeof(CharType));
+				out += pieces[i].size;
+			}
+
+			return result;
+		}
+
+		template <typename CharType, typename... Types>
+		base_string<CharType> concat_imp(const Types&... values)
+		{
+			const string_piece<CharType> pieces[] = { make_piece<CharType>(values)... };
+
+			size_t total_size = 0;
+			for (const auto& piece : pieces)
+				total_size += piece.size;
+
+			return join_pieces(pieces, sizeof...(Types), total_size);
+		}
+	}
+
+	// collects pieces and joins them in build() with a single allocation, instead of reallocating on every +=.
+	// strings are kept as views, so they must outlive the call to build, appending a temporary string does not compile.
+	// numbers are formatted when appended.
+	// crt::string_builder b; b << "took " << ms << "ms for " << count << " items"; auto s = b.build();
+	template <typename CharType>
+	class base_string_builder
+	{
+	public:
+		base_string_builder() = default;
+
+		explicit base_string_builder(size_t piece_capacity)
+		{
+			pieces_.reserve(piece_capacity);
+		}
+
+		template <typename T>
+		base_string_builder& append(const T& value)
+		{
+			return push(detail::make_piece<CharType>(value));
+		}
+
+		template <typename T, typename = std::enable_if_t<detail::is_temporary_string_v<CharType, T>>>
+		base_string_builder& append(T&& value) = delete;
+
+		base_string_builder& append(const CharType* str, size_t size)
+		{
+			return push(detail::make_piece(str, size));
+		}
+
+		// floats are appended in their shortest round trip form, or with a fixed number of decimals here,
+		// at most max_float_decimals
+		base_string_builder& append(double value, size_t decimals)
+		{
+			return push(detail::make_float_piece<CharType>(value, decimals));
+		}
+
+		template <typename T>
+		base_string_builder& operator<<(const T& value)
+		{
+			return append(value);
+		}
+
+		template <typename T, typename = std::enable_if_t<detail::is_temporary_string_v<CharType, T>>>
+		base_string_builder& operator<<(T&& value) = delete;
+
+		base_string<CharType> build() const
+		{
+			return detail::join_pieces(pieces_.data(), pieces_.size(), size_);
+		}
+
+		// number of characters build will produce
+		size_t size() const
+		{
+			return size_;
+		}
+
+		bool empty() const
+		{
+			return size_ == 0;
+		}
+
+		void clear()
+		{
+			pieces_.erase();
+			size_ = 0;
+		}
+
+	private:
+		base_string_builder& push(const detail::string_piece<CharType>& piece)
+		{
+			size_ += piece.size;
+			pieces_.push_back(piece);
+			return *this;
+		}
+
+		vector<detail::string_piece<CharType>> pieces_{};
+		size_t size_{};
+	};
+
+	typedef base_string_builder<char>		string_builder;
+	typedef base_string_builder<wchar_t>	wstring_builder;
+
+	// concat("[", day, "-", month, "] ", message) joins strings, characters and numbers with one allocation
+	template <typename T, typename... Types>
+	string concat(const T& value, const Types&... values)
+	{
+		return detail::concat_imp<char>(value, values...);
+	}
+
+	template <typename T, typename... Types>
+	wstring concat_wide(const T& value, const Types&... values)
+	{
+		return detail::concat_imp<wchar_t>(value, values...);
+	}
+}
@@ -1,5 +1,6 @@
 #pragma once
 #include "my_string.hpp"
+#include "charconv.hpp"
 #include "maybe.hpp"
 #include "algorithm.hpp"
 
@@ -8,71 +9,34 @@ namespace crt
 	namespace detail
 	{
 		template <typename CharType, typename IntType>
-		base_string<CharType> int_to_hex_imp(IntType integer, size_t character_count = sizeof(IntType) << 1)
+		base_string<CharType> int_to_hex_imp(IntType integer)
 		{
 			if constexpr (std::is_same_v<IntType, bool>)
+			{
 				return integer ? "1" : "0";
-
-			crt::base_string<CharType> str(character_count, 0);
-			for (size_t i = 0, j = (character_count - 1) * 4; i < character_count; ++i, j -= 4)
+			}
+			else
 			{
-				const CharType digit_value = (integer >> j) & 0x0f;
-				const CharType digit_character = digit_value < 10 ? 0x30 + digit_value : 0x41 + (digit_value - 10);
-				str[i] = digit_character;
+				// negative values are printed in two's complement
+				CharType buffer[max_integer_chars];
+				const auto result = to_chars(buffer, buffer + max_integer_chars, static_cast<std::make_unsigned_t<IntType>>(integer), 16);
+				return base_string<CharType>(buffer, result.end - buffer);
 			}
-
-			auto start = crt::find_first_not_of(str.begin(), str.end(), '0');
-			if (start == str.end() && str[str.size() - 1] == '0')
-				start = &str[str.size() - 1];
-			return start != str.end() ? crt::slice(str, start, str.end()) : str;
 		}
 
 		template <typename CharType, typename IntType>
 		crt::base_string<CharType> int_to_dec_imp(IntType integer)
 		{
 			if constexpr (std::is_same_v<IntType, bool>)
-				return integer ? "1" : "0";
-
-			crt::base_string<CharType> resulting_digits;
-
-			bool negative = false;
-			if constexpr (std::is_signed_v<IntType>)
-			{
-				// handle negative number
-				if (integer < 0)
-				{
-					negative = true;
-					integer = -integer;
-				}
-			}
-
-			IntType quotient, remainder;
-			while (integer)
-			{
-				quotient = integer / 10;
-				remainder = integer % 10;		// digits
-
-				resulting_digits.push_back(static_cast<CharType>(remainder) + 0x30);
-
-				integer = quotient;
-			}
-
-			if (negative)
 			{
-				resulting_digits.push_back(static_cast<CharType>(0x2D));
-			}
-
-			// integer was 0.
-			if (resulting_digits.empty())
-			{
-				resulting_digits.push_back(0x30); // push 0
+				return integer ? "1" : "0";
 			}
 			else
 			{
-				crt::reverse(resulting_digits.begin(), resulting_digits.end());
+				CharType buffer[max_integer_chars];
+				const auto result = to_chars(buffer, buffer + max_integer_chars, integer);
+				return base_string<CharType>(buffer, result.end - buffer);
 			}
-
-			return resulting_digits;
 		}
 	}
 
@@ -130,22 +94,16 @@ namespace crt
 	}
 
 
+	// the whole string as an unsigned number in base, nothing if anything else is in it or it does not fit
 	template <typename CharType>
 	crt::maybe<uint32_t> string_to_int(const CharType* p_string, uint32_t base = 16)
 	{
-		const auto size_of_string = static_cast<int>(detail::strlen_imp(p_string));
-
-		uint32_t value = 0;
-		size_t digit_idx = 0;
-		for (int i = size_of_string - 1; i >= 0; --i)
-		{
-			if (!is_digit(p_string[i]))
-				return nothing<uint32_t>();
+		const auto end = p_string + detail::strlen_imp(p_string);
 
-			value += get_digit_value_of_character(p_string[i]) * exponent(base, digit_idx);
-
-			digit_idx++;
-		}
+		uint32_t value;
+		const auto result = from_chars(p_string, end, value, base);
+		if (result.error != chars_error::none || result.end != end)
+			return nothing<uint32_t>();
 
 		return just<uint32_t>(value);
 	}
@@ -155,4 +113,112 @@ namespace crt
 	{
 		return static_cast<uint8_t>(*string_to_int<char>(str.c_str(), 16));
 	}
+
+	/* ascii case insensitive helpers, they fold the characters while comparing instead of lowering copies */
+	template <typename CharType>
+	constexpr bool iequals(const base_string<CharType>& lhs, const base_string<CharType>& rhs)
+	{
+		return lhs.size() == rhs.size() && detail::iequal_imp(lhs.c_str(), rhs.c_str(), lhs.size());
+	}
+
+	template <typename CharType>
+	constexpr bool iequals(const base_string<CharType>& lhs, const CharType* rhs)
+	{
+		const auto size = detail::strlen_imp(rhs);
+		return lhs.size() == size && detail::iequal_imp(lhs.c_str(), rhs, size);
+	}
+
+	template <typename CharType>
+	constexpr bool istarts_with(const base_string<CharType>& str, const base_string<CharType>& prefix)
+	{
+		return str.size() >= prefix.size() && detail::iequal_imp(str.c_str(), prefix.c_str(), prefix.size());
+	}
+
+	template <typename CharType>
+	constexpr bool istarts_with(const base_string<CharType>& str, const CharType* prefix)
+	{
+		const auto size = detail::strlen_imp(prefix);
+		return str.size() >= size && detail::iequal_imp(str.c_str(), prefix, size);
+	}
+
+	// returns first occurrence of needle in str starting at pos ignoring ascii case, nullptr if can't find
+	template <typename CharType>
+	constexpr const CharType* ifind(const base_string<CharType>& str, const CharType* needle, size_t needle_size, size_t pos)
+	{
+		if (pos > str.size())
+			return nullptr;
+
+		return detail::ifind_imp(str.c_str() + pos, str.size() - pos, needle, needle_size);
+	}
+
+	template <typename CharType>
+	constexpr const CharType* ifind(const base_string<CharType>& str, const CharType* needle, size_t pos = 0)
+	{
+		return ifind(str, needle, detail::strlen_imp(needle), pos);
+	}
+
+	template <typename CharType>
+	constexpr const CharType* ifind(const base_string<CharType>& str, const base_string<CharType>& needle, size_t pos = 0)
+	{
+		return ifind(str, needle.c_str(), needle.size(), pos);
+	}
+
+	template <typename CharType>
+	base_string<CharType> to_lower(const base_string<CharType>& str)
+	{
+		base_string<CharType> result;
+		result.reserve(str.size());
+		detail::to_lower_imp(str.c_str(), str.size(), result.c_str());
+		result.resize(str.size());
+		return result;
+	}
+
+	template <typename CharType>
+	base_string<CharType> to_upper(const base_string<CharType>& str)
+	{
+		base_string<CharType> result;
+		result.reserve(str.size());
+		detail::to_upper_imp(str.c_str(), str.size(), result.c_str());
+		result.resize(str.size());
+		return result;
+	}
+
+	// equal for strings that differ only in ascii case. the characters are lowered in blocks on the stack
+	// and the blocks chained through the seed, so no lower case copy of the string is allocated.
+	template <typename CharType>
+	size_t get_case_insensitive_hash(const CharType* str, size_t size)
+	{
+		constexpr size_t block_size = 128;
+		CharType block[block_size];
+
+		uint64_t hash = 0;
+		do
+		{
+			const auto count = size < block_size ? size : block_size;
+			detail::to_lower_imp(str, count, block);
+			hash = hash_bytes(block, count * sizeof(CharType), hash);
+
+			str += count;
+			size -= count;
+		} while (size);
+
+		return detail::fold_hash(hash);
+	}
+
+	// hash_map key traits for strings that are compared ignoring ascii case, e.g. module names:
+	// crt::hash_map<crt::string, HMODULE, crt::case_insensitive_key_traits> modules;
+	struct case_insensitive_key_traits
+	{
+		template <typename CharType>
+		static size_t hash(const base_string<CharType>& key)
+		{
+			return get_case_insensitive_hash(key.c_str(), key.size());
+		}
+
+		template <typename CharType>
+		static constexpr bool equal(const base_string<CharType>& lhs, const base_string<CharType>& rhs)
+		{
+			return iequals(lhs, rhs);
+		}
+	};
 }
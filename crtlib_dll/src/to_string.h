@@ -16,9 +16,13 @@ namespace crt
 	std::enable_if_t<!std::is_pointer_v<IntType>, crt::string>
 		to_string(IntType value)
 	{
-		return to_string(crt::int_to_hex(value));
+		return crt::int_to_hex(value);
 	}
 
 	crt::string to_string(const void* pointer);
 
+	/* shortest representation that parses back to the same value */
+	crt::string to_string(double value);
+	crt::string to_string(float value);
+
 }
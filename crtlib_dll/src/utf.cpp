@@ -0,0 +1,342 @@
+#include "utf.hpp"
+#include <intrin.h>
+#include <emmintrin.h>
+
+namespace crt
+{
+	// returned by the decoders for an invalid subpart, the encoders write replacement_character for it
+	constexpr uint32_t invalid_code_point = 0xFFFFFFFF;
+
+	constexpr size_t utf_block_size = 16;
+
+	static uint32_t lowest_set_bit(uint32_t mask)
+	{
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+	}
+
+	// decodes the code point at the start of str, size > 0. returns the number of bytes consumed,
+	// an invalid sequence consumes its maximal subpart: the bytes up to the first one that can not continue it
+	static size_t decode_utf8(const uint8_t* str, size_t size, uint32_t& code_point)
+	{
+		const uint32_t lead = str[0];
+		if (lead < 0x80)
+		{
+			code_point = lead;
+			return 1;
+		}
+
+		// the allowed range of the second byte excludes overlong forms, surrogates and values past U+10FFFF
+		size_t length;
+		uint8_t low = 0x80;
+		uint8_t high = 0xBF;
+		if (lead >= 0xC2 && lead <= 0xDF)
+		{
+			length = 2;
+			code_point = lead & 0x1F;
+		}
+		else if (lead >= 0xE0 && lead <= 0xEF)
+		{
+			length = 3;
+			code_point = lead & 0x0F;
+			if (lead == 0xE0)
+				low = 0xA0;
+			else if (lead == 0xED)
+				high = 0x9F;
+		}
+		else if (lead >= 0xF0 && lead <= 0xF4)
+		{
+			length = 4;
+			code_point = lead & 0x07;
+			if (lead == 0xF0)
+				low = 0x90;
+			else if (lead == 0xF4)
+				high = 0x8F;
+		}
+		else
+		{
+			code_point = invalid_code_point;
+			return 1;
+		}
+
+		for (size_t i = 1; i < length; ++i)
+		{
+			if (i >= size || str[i] < low || str[i] > high)
+			{
+				code_point = invalid_code_point;
+				return i;
+			}
+
+			code_point = (code_point << 6) | (str[i] & 0x3F);
+			low = 0x80;
+			high = 0xBF;
+		}
+
+		return length;
+	}
+
+	// returns the number of characters consumed
+	static size_t decode_wide(const wchar_t* str, size_t size, uint32_t& code_point)
+	{
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			const uint32_t unit = static_cast<uint16_t>(str[0]);
+			if (unit < 0xD800 || unit > 0xDFFF)
+			{
+				code_point = unit;
+				return 1;
+			}
+
+			if (unit <= 0xDBFF && size > 1)
+			{
+				const uint32_t next = static_cast<uint16_t>(str[1]);
+				if (next >= 0xDC00 && next <= 0xDFFF)
+				{
+					code_point = 0x10000 + ((unit - 0xD800) << 10) + (next - 0xDC00);
+					return 2;
+				}
+			}
+
+			// lone surrogate
+			code_point = invalid_code_point;
+			return 1;
+		}
+		else
+		{
+			const auto unit = static_cast<uint32_t>(str[0]);
+			code_point = unit > 0x10FFFF || (unit >= 0xD800 && unit <= 0xDFFF) ? invalid_code_point : unit;
+			return 1;
+		}
+	}
+
+	static size_t encode_utf8(uint32_t code_point, uint8_t* out)
+	{
+		if (code_point == invalid_code_point)
+			code_point = replacement_character;
+
+		if (code_point < 0x80)
+		{
+			out[0] = static_cast<uint8_t>(code_point);
+			return 1;
+		}
+
+		if (code_point < 0x800)
+		{
+			out[0] = static_cast<uint8_t>(0xC0 | (code_point >> 6));
+			out[1] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+			return 2;
+		}
+
+		if (code_point < 0x10000)
+		{
+			out[0] = static_cast<uint8_t>(0xE0 | (code_point >> 12));
+			out[1] = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3F));
+			out[2] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+			return 3;
+		}
+
+		out[0] = static_cast<uint8_t>(0xF0 | (code_point >> 18));
+		out[1] = static_cast<uint8_t>(0x80 | ((code_point >> 12) & 0x3F));
+		out[2] = static_cast<uint8_t>(0x80 | ((code_point >> 6) & 0x3F));
+		out[3] = static_cast<uint8_t>(0x80 | (code_point & 0x3F));
+		return 4;
+	}
+
+	static size_t encode_wide(uint32_t code_point, wchar_t* out)
+	{
+		if (code_point == invalid_code_point)
+			code_point = replacement_character;
+
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			if (code_point >= 0x10000)
+			{
+				code_point -= 0x10000;
+				out[0] = static_cast<wchar_t>(0xD800 + (code_point >> 10));
+				out[1] = static_cast<wchar_t>(0xDC00 + (code_point & 0x3FF));
+				return 2;
+			}
+		}
+
+		out[0] = static_cast<wchar_t>(code_point);
+		return 1;
+	}
+
+	// 16 ascii bytes to 16 wide characters
+	static void widen_ascii_block(__m128i block, wchar_t* out)
+	{
+		const auto zero = _mm_setzero_si128();
+		const auto low = _mm_unpacklo_epi8(block, zero);
+		const auto high = _mm_unpackhi_epi8(block, zero);
+
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), low);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), high);
+		}
+		else
+		{
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi16(low, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4), _mm_unpackhi_epi16(low, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8), _mm_unpacklo_epi16(high, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 12), _mm_unpackhi_epi16(high, zero));
+		}
+	}
+
+	// if the 16 wide characters at str are all ascii, narrows them into out and returns true
+	static bool narrow_ascii_block(const wchar_t* str, uint8_t* out)
+	{
+		const auto zero = _mm_setzero_si128();
+		__m128i packed;
+
+		if constexpr (sizeof(wchar_t) == 2)
+		{
+			const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+			const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 8));
+			const auto high_bits = _mm_and_si128(_mm_or_si128(a, b), _mm_set1_epi16(static_cast<short>(0xFF80)));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi16(high_bits, zero)) != 0xFFFF)
+				return false;
+
+			packed = _mm_packus_epi16(a, b);
+		}
+		else
+		{
+			const auto a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str));
+			const auto b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 4));
+			const auto c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 8));
+			const auto d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(str + 12));
+			const auto any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+			const auto high_bits = _mm_and_si128(any, _mm_set1_epi32(static_cast<int>(0xFFFFFF80)));
+			if (_mm_movemask_epi8(_mm_cmpeq_epi32(high_bits, zero)) != 0xFFFF)
+				return false;
+
+			packed = _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+		}
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), packed);
+		return true;
+	}
+
+	size_t utf8_to_wide(const char* str, size_t size, wchar_t* out)
+	{
+		const auto in = reinterpret_cast<const uint8_t*>(str);
+		auto written = out;
+
+		size_t i = 0;
+		while (i < size)
+		{
+			auto block_end = size;
+			if (i + utf_block_size <= size)
+			{
+				const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+				const auto non_ascii = static_cast<uint32_t>(_mm_movemask_epi8(block));
+				if (!non_ascii)
+				{
+					widen_ascii_block(block, written);
+					i += utf_block_size;
+					written += utf_block_size;
+					continue;
+				}
+
+				// copy the ascii prefix, decode the rest of the block one code point at a time
+				for (auto ascii = lowest_set_bit(non_ascii); ascii; --ascii)
+					*written++ = static_cast<wchar_t>(in[i++]);
+
+				block_end = i + utf_block_size;
+			}
+
+			while (i < block_end && i < size)
+			{
+				uint32_t code_point;
+				i += decode_utf8(in + i, size - i, code_point);
+				written += encode_wide(code_point, written);
+			}
+		}
+
+		return written - out;
+	}
+
+	size_t wide_to_utf8(const wchar_t* str, size_t size, char* out)
+	{
+		const auto begin = reinterpret_cast<uint8_t*>(out);
+		auto written = begin;
+
+		size_t i = 0;
+		while (i < size)
+		{
+			auto block_end = size;
+			if (i + utf_block_size <= size)
+			{
+				if (narrow_ascii_block(str + i, written))
+				{
+					i += utf_block_size;
+					written += utf_block_size;
+					continue;
+				}
+
+				block_end = i + utf_block_size;
+			}
+
+			while (i < block_end && i < size)
+			{
+				uint32_t code_point;
+				i += decode_wide(str + i, size - i, code_point);
+				written += encode_utf8(code_point, written);
+			}
+		}
+
+		return written - begin;
+	}
+
+	wstring utf8_to_wide(const char* str, size_t size)
+	{
+		wstring result;
+		result.reserve(size);
+		result.resize(utf8_to_wide(str, size, result.c_str()));
+		return result;
+	}
+
+	string wide_to_utf8(const wchar_t* str, size_t size)
+	{
+		string result;
+		result.reserve(size * max_utf8_per_wide);
+		result.resize(wide_to_utf8(str, size, result.c_str()));
+		return result;
+	}
+
+	bool is_valid_utf8(const char* str, size_t size)
+	{
+		const auto in = reinterpret_cast<const uint8_t*>(str);
+
+		size_t i = 0;
+		while (i < size)
+		{
+			if (i + utf_block_size <= size && !_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i))))
+			{
+				i += utf_block_size;
+				continue;
+			}
+
+			uint32_t code_point;
+			i += decode_utf8(in + i, size - i, code_point);
+			if (code_point == invalid_code_point)
+				return false;
+		}
+
+		return true;
+	}
+
+	bool is_valid_wide(const wchar_t* str, size_t size)
+	{
+		for (size_t i = 0; i < size; )
+		{
+			uint32_t code_point;
+			i += decode_wide(str + i, size - i, code_point);
+			if (code_point == invalid_code_point)
+				return false;
+		}
+
+		return true;
+	}
+}
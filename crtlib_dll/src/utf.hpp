@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+
+#include "my_string.hpp"
+
+namespace crt
+{
+	// wchar_t is utf-16 on windows and utf-32 where it is 4 bytes wide
+	constexpr size_t max_utf8_per_wide = sizeof(wchar_t) == 2 ? 3 : 4;
+
+	constexpr uint32_t replacement_character = 0xFFFD;
+
+	// the conversions never fail: invalid input (bad or truncated utf-8 sequences, lone surrogates, values past
+	// U+10FFFF) is replaced with U+FFFD, one for every maximal invalid subpart, like the win32 converters do.
+
+	// writes at most size characters to out, returns the number written
+	size_t utf8_to_wide(const char* str, size_t size, wchar_t* out);
+
+	// writes at most size * max_utf8_per_wide bytes to out, returns the number written
+	size_t wide_to_utf8(const wchar_t* str, size_t size, char* out);
+
+	// converted with a single allocation sized by the upper bound above
+	wstring utf8_to_wide(const char* str, size_t size);
+	string wide_to_utf8(const wchar_t* str, size_t size);
+
+	inline wstring utf8_to_wide(const string& str)
+	{
+		return utf8_to_wide(str.c_str(), str.size());
+	}
+
+	inline string wide_to_utf8(const wstring& str)
+	{
+		return wide_to_utf8(str.c_str(), str.size());
+	}
+
+	bool is_valid_utf8(const char* str, size_t size);
+	bool is_valid_wide(const wchar_t* str, size_t size);
+}